@@ -0,0 +1,57 @@
+# Generates the build id header, run as a script on every build:
+#   cmake -DSOURCE_DIR=<repo> -DOUTPUT=<header> -P EchoBuildId.cmake
+#
+# The id is the git revision together with a hash of the compiler sources, so it changes
+# with every change to the compiler, committed or not. It contains no timestamps, building
+# the same sources twice gives the same id.
+
+set(ECHO_GIT_DESCRIBE "unknown")
+
+find_package(Git QUIET)
+if (GIT_FOUND)
+    execute_process(
+        COMMAND ${GIT_EXECUTABLE} describe --always --dirty --abbrev=12
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE GIT_DESCRIBE_OUTPUT
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        RESULT_VARIABLE GIT_DESCRIBE_RESULT
+        ERROR_QUIET
+    )
+    if (GIT_DESCRIBE_RESULT EQUAL 0)
+        set(ECHO_GIT_DESCRIBE ${GIT_DESCRIBE_OUTPUT})
+    endif()
+endif()
+
+# the git revision alone misses uncommitted edits, so the sources are hashed as well
+file(GLOB_RECURSE ECHO_SOURCES RELATIVE ${SOURCE_DIR}
+    "${SOURCE_DIR}/src/*.cpp"
+    "${SOURCE_DIR}/include/*.h"
+    "${SOURCE_DIR}/runtime/*.c"
+    "${SOURCE_DIR}/runtime/*.h"
+)
+list(APPEND ECHO_SOURCES CMakeLists.txt)
+list(SORT ECHO_SOURCES)
+
+set(ECHO_SOURCE_HASHES "")
+foreach(source ${ECHO_SOURCES})
+    file(SHA256 "${SOURCE_DIR}/${source}" source_hash)
+    string(APPEND ECHO_SOURCE_HASHES "${source}:${source_hash}\n")
+endforeach()
+string(SHA256 ECHO_SOURCE_HASH "${ECHO_SOURCE_HASHES}")
+
+set(ECHO_BUILD_ID "${ECHO_GIT_DESCRIBE}-${ECHO_SOURCE_HASH}")
+
+set(HEADER_CONTENT "// generated by cmake/EchoBuildId.cmake, do not edit
+#ifndef ECHO_BUILD_ID
+#define ECHO_BUILD_ID \"${ECHO_BUILD_ID}\"
+#endif
+")
+
+# only touch the header when the id changed, otherwise everything including it would be rebuilt
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} EXISTING_CONTENT)
+endif()
+
+if (NOT "${EXISTING_CONTENT}" STREQUAL "${HEADER_CONTENT}")
+    file(WRITE ${OUTPUT} "${HEADER_CONTENT}")
+endif()
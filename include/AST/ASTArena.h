@@ -0,0 +1,123 @@
+#ifndef ASTARENA_H
+#define ASTARENA_H
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace AST
+{
+    /**
+     * A chunked bump allocator
+     * 
+     * Memory is handed out from large chunks by simply moving a pointer forward, 
+     * chunks are never resized or moved so addresses stay stable for the lifetime of the arena.
+     * The arena does not know anything about the objects living in it, destruction 
+     * is up to the owner, all memory is released at once when the arena goes away.
+     */
+    class Arena
+    {
+    public:
+        static constexpr size_t default_chunk_size = 64 * 1024;
+
+        explicit Arena(size_t chunk_size = default_chunk_size) : 
+            _chunk_size(chunk_size) 
+        {}
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        Arena(Arena &&other) noexcept :
+            _chunks(std::move(other._chunks)),
+            _ptr(std::exchange(other._ptr, nullptr)),
+            _end(std::exchange(other._end, nullptr)),
+            _chunk_size(other._chunk_size),
+            _bytes_used(std::exchange(other._bytes_used, 0))
+        {
+            other._chunks.clear();
+        }
+
+        inline void *allocate(size_t size, size_t alignment) 
+        {
+            assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+            auto p = align_up(_ptr, alignment);
+            if (_ptr == nullptr || p + size > _end) {
+                grow(size + alignment);
+                p = align_up(_ptr, alignment);
+            }
+
+            _ptr = p + size;
+            _bytes_used += size;
+
+            return p;
+        }
+
+        template <typename T>
+        inline void *allocate_for() {
+            return allocate(sizeof(T), alignof(T));
+        }
+
+        // takes over the chunks of the other arena, allocation continues in our current chunk
+        inline void merge(Arena &&other) 
+        {
+            _chunks.reserve(_chunks.size() + other._chunks.size());
+            for (auto &chunk : other._chunks) {
+                _chunks.push_back(std::move(chunk));
+            }
+
+            _bytes_used += other._bytes_used;
+
+            other._chunks.clear();
+            other._ptr = nullptr;
+            other._end = nullptr;
+            other._bytes_used = 0;
+        }
+
+        inline size_t bytes_used() const {
+            return _bytes_used;
+        }
+
+        inline size_t chunk_count() const {
+            return _chunks.size();
+        }
+
+        // frees all chunks, everything allocated from the arena is gone afterwards
+        inline void release()
+        {
+            _chunks.clear();
+            _chunks.shrink_to_fit();
+            _ptr = nullptr;
+            _end = nullptr;
+            _bytes_used = 0;
+        }
+
+    private:
+        std::vector<std::unique_ptr<std::byte[]>> _chunks;
+        std::byte *_ptr = nullptr;
+        std::byte *_end = nullptr;
+        size_t _chunk_size;
+        size_t _bytes_used = 0;
+
+        static inline std::byte *align_up(std::byte *p, size_t alignment) {
+            auto addr = reinterpret_cast<uintptr_t>(p);
+            return reinterpret_cast<std::byte *>((addr + alignment - 1) & ~(alignment - 1));
+        }
+
+        inline void grow(size_t min_size) 
+        {
+            // allocations larger than a chunk get a chunk of their own size
+            auto size = min_size > _chunk_size ? min_size : _chunk_size;
+            _chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+            _ptr = _chunks.back().get();
+            _end = _ptr + size;
+        }
+    };
+};
+
+#endif
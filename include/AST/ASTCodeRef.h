@@ -37,21 +37,21 @@ namespace AST
 
         const std::string get_referenced_code_excerpt() const
         {
-            if (!file->file->content.has_value()) {
+            if (!file->file->has_content()) {
                 return "[No content available]";
             }
 
-            // const auto &content = file->file->content.value();
-
             auto lines = line_range();
 
             std::string excerpt;
-            excerpt += "Begin: '" + token_slice.start_ref().value() + "'\n";
-            excerpt += "End: '" + token_slice.end_ref().value() + "'\n";
+            excerpt += "Begin: '" + std::string(token_slice.start_ref().value()) + "'\n";
+            excerpt += "End: '" + std::string(token_slice.end_ref().value()) + "'\n";
             excerpt += "Code excerpt:\n";
 
             for (uint32_t i = std::get<0>(lines) - 1; i <= std::get<1>(lines) + 1; i++) {
-                excerpt += " [" + std::to_string(i) + "]> " + file->file->get_content_of_line(i) + "\n";
+                excerpt += " [" + std::to_string(i) + "]> ";
+                excerpt += file->file->get_content_of_line(i);
+                excerpt += "\n";
                 if (i == std::get<0>(lines)) {
                     excerpt += "     ";
                     for (uint32_t j = 0; j < token_slice.startt().char_offset; j++) {
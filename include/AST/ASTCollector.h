@@ -25,6 +25,9 @@ namespace AST
             issues.push_back(std::make_unique<T>(code_ref, args...));
         }
 
+        // takes over the issues of a collector that was used for a single file / thread
+        void merge(Collector &&other);
+
         void print_issues() const;
 
         bool has_critical_issues() const;
@@ -0,0 +1,173 @@
+#ifndef ASTCOMPACT_H
+#define ASTCOMPACT_H
+
+#pragma once
+
+#include "ASTValueType.h"
+#include "../SymbolTable.h"
+#include "../Token.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace AST
+{
+    class ScopeNode;
+
+    /**
+     * Compact, index based representation of a parsed file
+     *
+     * The node classes are convenient while parsing (scopes are resolved, types inferred etc.)
+     * but every node is a separate polymorphic object linked by pointers. Once a file has been
+     * parsed it is lowered into this tree: every node kind has its own structure of arrays,
+     * nodes reference each other with 32 bit handles and child lists are contiguous
+     * ranges in a single shared array. Types are resolved to their primitive during lowering
+     * so consumers never have to walk an expression to find out its type.
+     */
+    enum class CompactKind : uint8_t {
+        c_none,
+        c_scope,
+        c_vardecl,
+        c_literal_int,
+        c_literal_float,
+        c_literal_bool,
+        c_varref,
+        c_call,
+        c_binary,
+        c_unary,
+        c_cast,
+        c_func_decl,
+        c_return,
+        c_if,
+    };
+
+    // the upper 8 bits hold the kind, the lower 24 bits the index into the storage of that kind
+    typedef uint32_t cnode_t;
+
+    constexpr cnode_t cnode_none = 0;
+
+    constexpr uint32_t cnode_max_index = 0x00FFFFFF;
+
+    // a kind with more nodes than fit into the index would corrupt the handles, so this is checked in release builds too
+    constexpr cnode_t make_cnode(CompactKind kind, uint32_t index) {
+        if (index > cnode_max_index) {
+            throw std::length_error("Compact tree storage overflow, a file has more than 2^24 nodes of one kind");
+        }
+        return (static_cast<uint32_t>(kind) << 24) | index;
+    }
+
+    constexpr CompactKind cnode_kind(cnode_t node) {
+        return static_cast<CompactKind>(node >> 24);
+    }
+
+    constexpr uint32_t cnode_index(cnode_t node) {
+        return node & cnode_max_index;
+    }
+
+    // a range in the trees shared `children` array
+    struct CompactRange {
+        uint32_t begin = 0;
+        uint32_t count = 0;
+    };
+
+    class CompactTree
+    {
+    public:
+        // child lists of all nodes, scope statements, call & function arguments and
+        // if blocks, which are stored as (condition, scope) pairs with `cnode_none` for else
+        std::vector<cnode_t> children;
+
+        struct {
+            std::vector<CompactRange> children;
+        } scopes;
+
+        struct {
+            std::vector<symbol_t> symbol;
+            std::vector<ValueTypePrimitive> type;
+            std::vector<cnode_t> init;
+        } vardecls;
+
+        struct {
+            std::vector<ValueTypePrimitive> type;
+            std::vector<uint64_t> value;
+        } int_literals;
+
+        struct {
+            std::vector<ValueTypePrimitive> type;
+            std::vector<double> value;
+        } float_literals;
+
+        struct {
+            std::vector<uint8_t> value;
+        } bool_literals;
+
+        struct {
+            // index into `vardecls`
+            std::vector<uint32_t> decl;
+        } varrefs;
+
+        struct {
+            std::vector<symbol_t> callee;
+            std::vector<Token::Type> callee_type;
+            std::vector<CompactRange> args;
+            std::vector<ValueTypePrimitive> type;
+        } calls;
+
+        struct {
+            std::vector<Token::Type> op;
+            std::vector<cnode_t> lhs;
+            std::vector<cnode_t> rhs;
+            std::vector<ValueTypePrimitive> type;
+        } binaries;
+
+        struct {
+            std::vector<Token::Type> op;
+            std::vector<cnode_t> expr;
+        } unaries;
+
+        struct {
+            std::vector<ValueTypePrimitive> type;
+            std::vector<cnode_t> expr;
+        } casts;
+
+        struct {
+            std::vector<symbol_t> name;
+            std::vector<ValueTypePrimitive> return_type;
+            // the arguments are vardecl nodes
+            std::vector<CompactRange> args;
+            std::vector<cnode_t> body;
+        } functions;
+
+        struct {
+            std::vector<cnode_t> expr;
+        } returns;
+
+        struct {
+            std::vector<CompactRange> blocks;
+        } ifs;
+
+        cnode_t root = cnode_none;
+
+        inline const cnode_t *begin(CompactRange range) const {
+            return children.data() + range.begin;
+        }
+
+        inline const cnode_t *end(CompactRange range) const {
+            return children.data() + range.begin + range.count;
+        }
+
+        // the primitive type the given expression evaluates to
+        ValueTypePrimitive result_type(cnode_t expr) const;
+
+        size_t node_count() const;
+
+        // bytes used by the node storage
+        size_t memory_usage() const;
+    };
+
+    // lowers the given, fully parsed, scope and everything below it into the tree
+    void lower_to_compact(ScopeNode &root, CompactTree &tree);
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef ASTCONSTANTFOLDING_H
+#define ASTCONSTANTFOLDING_H
+
+#pragma once
+
+namespace AST
+{
+    class Node;
+    class NodeCollection;
+
+    // replaces expressions that only operate on literals with the literal they evaluate to, uses
+    // of const variables with a literal initializer with that literal and removes the blocks
+    // of if statements whose condition is a constant. Folded literals are allocated in `nodes`.
+    // Runs on a fully parsed tree, before `annotate_types`.
+    void fold_constants(Node &root, NodeCollection &nodes);
+};
+
+#endif
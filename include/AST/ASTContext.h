@@ -15,6 +15,10 @@ namespace AST
 
         const TokenizedFile &file;
 
+        // where new nodes are allocated, usually the modules node collection
+        // but files parsed concurrently get their own which is merged afterwards
+        NodeCollection &nodes;
+
         ScopeNode *scope_ptr = nullptr;
 
         inline ScopeNode &scope() const {
@@ -29,7 +33,7 @@ namespace AST
         template <typename T, typename... Args>
             requires NodeTypeProvider<T>
         inline T &emplace_node(Args&&... args) {
-            return module.nodes.emplace_back<T>(std::forward<Args>(args)...);
+            return nodes.emplace_back<T>(std::forward<Args>(args)...);
         }
 
         CodeRef code_ref(const TokenSlice &slice) const {
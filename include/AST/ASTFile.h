@@ -5,10 +5,12 @@
 
 #include <filesystem>
 #include <string>
-#include <optional>
+#include <string_view>
+#include <cassert>
 
 #include "../Token.h"
 #include "ScopeNode.h"
+#include "ASTCompact.h"
 
 namespace AST
 {  
@@ -42,37 +44,70 @@ namespace AST
         // we will store a offset to the start of each line in the content
         std::vector<size_t> _line_offsets;
 
+        // the content is either a read only mapping of the file on disk
+        // or a buffer owned by the file, `_content` is a view into one of them
+        std::string_view _content;
+        std::string _owned_content;
+        void *_mapping = nullptr;
+        size_t _mapping_size = 0;
+        bool _has_content = false;
+
+        void release_content();
+
+        // points the content at the given buffer and rebuilds the line offsets
+        void update_content_view(std::string_view content);
+
     public:
 
         Module *module = nullptr;
 
         ScopeNode *root = nullptr;
 
-        // the plain text content of the file
-        std::optional<std::string> content;
+        // the lowered form of `root`, built by the parser once the file is complete
+        CompactTree compact;
 
-        
         File(
             const std::filesystem::path &path
         ) : 
             _path(path)
         {};
-        ~File() {};
+        ~File();
+
+        // token values and code refs point into the content, 
+        // so a file must never be copied or moved
+        File(const File &) = delete;
+        File &operator=(const File &) = delete;
 
         const std::filesystem::path &get_path() const {
             return _path;
         }
 
+        inline bool has_content() const {
+            return _has_content;
+        }
+
+        // the plain text content of the file
+        inline std::string_view content() const {
+            assert(_has_content);
+            return _content;
+        }
+
+        // returns true if the content is a memory mapping of the file on disk
+        inline bool is_mapped() const {
+            return _mapping != nullptr;
+        }
+
         // sets the content of the file
         // this will also invalidate the line_offsets
-        void set_content(const std::string &content);
+        void set_content(std::string content);
 
-        // will read the file from disk and update the content
+        // will read the file from disk and update the content, where possible 
+        // the file is memory mapped instead of being copied
         void read_from_disk();
 
         std::string debug_description() const;
         
-        std::string get_content_of_line(uint32_t line) const;
+        std::string_view get_content_of_line(uint32_t line) const;
     };
 
     struct TokenizedFile
@@ -41,25 +41,41 @@ namespace AST
         std::string debug_description() const;
 
         File &add_file(const std::filesystem::path &path);
+
+        // takes over a file that has been created (and usually read) outside of the module
+        File &add_file(std::unique_ptr<File> file);
         
         TokenizedFile &tokenize(Lexer &lexer, const File &file);
 
+        // appends tokens that have been lexed separately (e.g. on another thread)
+        // to the module and registers them as the tokens of the given file
+        TokenizedFile &add_tokenized_file(const File &file, TokenCollection &&file_tokens);
+
         bool is_owner_of(const TokenReference &tokenref) const {
             return tokenref.belongs_to(tokens);
         }   
 
+        // frees the node trees of all files once they have been lowered into their compact trees,
+        // the roots are reset, the tokens and compact trees stay. Issues that point to nodes must not
+        // be used afterwards
+        void release_nodes();
+
         // file iterator
         FileIterable files() { return FileIterable(_files); }
 
     private:
 
         std::vector<std::unique_ptr<File>> _files;
-        std::vector<TokenizedFile> _tokenized_files;
+        // heap allocated, contexts and code refs point to them
+        std::vector<std::unique_ptr<TokenizedFile>> _tokenized_files;
 
     };
 
     struct ModuleCollection
     {
+        // all modules of the collection intern their symbols into this table
+        std::shared_ptr<SymbolTable> symbols = std::make_shared<SymbolTable>();
+
         ModuleCollection() {}
         ~ModuleCollection() {}
 
@@ -73,6 +89,10 @@ namespace AST
             return handle < _modules.size();
         }
 
+        inline size_t size() const {
+            return _modules.size();
+        }
+
         Module *find_module_ptr(const std::string &name);
 
         Module &find_module(const std::string &name);
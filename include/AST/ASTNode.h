@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
+#include "ASTArena.h"
 #include "ASTNodeTypes.h"
 #include "ASTNodeReference.h"
 #include "ASTVisitor.h"
@@ -14,9 +16,19 @@ namespace AST
 {
     class Node
     {
+        friend class NodeCollection;
+
+        // set by the node collection when the node is created, passes can switch on it 
+        // instead of going through `accept`, nodes created elsewhere stay `n_void`
+        NodeType _type_tag = NodeType::n_void;
+
     public:
         virtual ~Node() {}
 
+        inline NodeType type_tag() const {
+            return _type_tag;
+        }
+
         virtual const std::string node_description() = 0;
 
         virtual bool is_assignable() {
@@ -26,26 +38,88 @@ namespace AST
         virtual void accept(Visitor &visitor) = 0;
     };
 
-    typedef std::vector<std::unique_ptr<Node>> NodeList;
-
-
-    // node collection is just a wrapper around a node list
+    /**
+     * Owns all nodes of a module (or of a single file while it is parsed)
+     * 
+     * Nodes are placement constructed in an arena instead of being allocated one by one, 
+     * so they are packed tightly in memory and freed in bulk. Node addresses never change
+     * which is required as nodes reference each other by pointer.
+     * Only nodes that are not trivially destructible are remembered to run their destructor.
+     */
     class NodeCollection
     {
-        std::unique_ptr<NodeList> nodes = std::make_unique<NodeList>();
+        Arena _arena;
+        std::vector<Node *> _destructibles;
+        size_t _count = 0;
+
     public:
+        NodeCollection() {}
+        ~NodeCollection() {
+            clear();
+        }
+
+        NodeCollection(const NodeCollection &) = delete;
+        NodeCollection &operator=(const NodeCollection &) = delete;
+
+        NodeCollection(NodeCollection &&other) noexcept :
+            _arena(std::move(other._arena)),
+            _destructibles(std::move(other._destructibles)),
+            _count(std::exchange(other._count, 0))
+        {
+            other._destructibles.clear();
+        }
 
         // emplace back 
         template <typename T, typename... Args>
             requires NodeTypeProvider<T>
         inline T &emplace_back(Args&&... args) {
-            auto node = std::make_unique<T>(std::forward<Args>(args)...);
-            auto &node_ref = *node;
-            nodes->push_back(std::move(node));
-            return node_ref;
+            auto node = new (_arena.allocate_for<T>()) T(std::forward<Args>(args)...);
+            node->_type_tag = T::node_type;
+
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                _destructibles.push_back(node);
+            }
+
+            _count++;
+            return *node;
+        }
+
+        // takes over all nodes of the other collection, the nodes 
+        // themselves are not moved so references to them stay valid
+        inline void merge(NodeCollection &&other) {
+            _arena.merge(std::move(other._arena));
+            _destructibles.insert(_destructibles.end(), other._destructibles.begin(), other._destructibles.end());
+            _count += other._count;
+
+            other._destructibles.clear();
+            other._count = 0;
+        }
+
+        inline size_t size() const {
+            return _count;
         }
 
-        
+        inline size_t bytes_used() const {
+            return _arena.bytes_used();
+        }
+
+        // destroys all nodes and frees their memory, every reference to them dangles afterwards
+        inline void release() {
+            clear();
+            _destructibles.shrink_to_fit();
+            _arena.release();
+        }
+
+    private:
+        // destroys the nodes in reverse order of their construction, the memory
+        // itself is released together with the arena
+        inline void clear() {
+            for (auto it = _destructibles.rbegin(); it != _destructibles.rend(); ++it) {
+                (*it)->~Node();
+            }
+            _destructibles.clear();
+            _count = 0;
+        }
     };
 };
 
@@ -28,6 +28,10 @@ namespace AST
             return parent_ptr;
         }
 
+        inline NodeType type() const {
+            return parent_type;
+        }
+
         inline bool has() const { 
             return parent_ptr != nullptr; 
         }
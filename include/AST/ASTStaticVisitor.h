@@ -0,0 +1,115 @@
+#ifndef ASTSTATICVISITOR_H
+#define ASTSTATICVISITOR_H
+
+#pragma once
+
+#include "ASTNode.h"
+#include "ASTNodeReference.h"
+#include "ASTVisitor.h"
+
+#include "ScopeNode.h"
+#include "TypeNode.h"
+#include "TypeCastNode.h"
+#include "VarDeclNode.h"
+#include "VarRefNode.h"
+#include "LiteralValueNode.h"
+#include "ExprNode.h"
+#include "NullNode.h"
+#include "OperatorNode.h"
+#include "FunctionDeclNode.h"
+#include "ReturnNode.h"
+#include "IfStatementNode.h"
+
+namespace AST
+{
+    /**
+     * Calls `f` with the node cast to its concrete type, selected by a switch over the
+     * given node type instead of a virtual call, so `f` can be inlined.
+     * Returns false if the type is not a concrete node type (e.g. an untagged node).
+     */
+    template <typename F>
+    inline bool visit(Node &node, NodeType type, F &&f)
+    {
+        switch (type) {
+            case NodeType::n_scope: f(static_cast<ScopeNode &>(node)); return true;
+            case NodeType::n_type: f(static_cast<TypeNode &>(node)); return true;
+            case NodeType::n_type_cast: f(static_cast<TypeCastNode &>(node)); return true;
+            case NodeType::n_vardecl: f(static_cast<VarDeclNode &>(node)); return true;
+            case NodeType::n_varref: f(static_cast<VarRefNode &>(node)); return true;
+            case NodeType::n_literal_float: f(static_cast<LiteralFloatExprNode &>(node)); return true;
+            case NodeType::n_literal_int: f(static_cast<LiteralIntExprNode &>(node)); return true;
+            case NodeType::n_literal_bool: f(static_cast<LiteralBoolExprNode &>(node)); return true;
+            case NodeType::n_expr_call: f(static_cast<FunctionCallExprNode &>(node)); return true;
+            case NodeType::n_expr_varref: f(static_cast<VarRefExprNode &>(node)); return true;
+            case NodeType::n_expr_binary: f(static_cast<BinaryExprNode &>(node)); return true;
+            case NodeType::n_expr_unary: f(static_cast<UnaryExprNode &>(node)); return true;
+            case NodeType::n_expr_void: f(static_cast<VoidExprNode &>(node)); return true;
+            case NodeType::n_null: f(static_cast<NullNode &>(node)); return true;
+            case NodeType::n_operator: f(static_cast<OperatorNode &>(node)); return true;
+            case NodeType::n_func_decl: f(static_cast<FunctionDeclNode &>(node)); return true;
+            case NodeType::n_func_return: f(static_cast<ReturnNode &>(node)); return true;
+            case NodeType::n_if_statement: f(static_cast<IfStatementNode &>(node)); return true;
+            default: return false;
+        }
+    }
+
+    template <typename F>
+    inline bool visit(const NodeReference &ref, F &&f) {
+        return ref.has() && visit(*ref.node(), ref.type(), std::forward<F>(f));
+    }
+
+    template <typename F>
+    inline bool visit(Node &node, F &&f) {
+        return visit(node, node.type_tag(), std::forward<F>(f));
+    }
+
+    /**
+     * Visitor base that dispatches on the node type tag instead of `accept`
+     *
+     * `dispatch` calls the `visitXxx` method of `Derived` directly, mark the derived
+     * class `final` so these calls are not virtual either. Nodes without a type tag
+     * fall back to the regular `accept`, so the derived class stays a normal `Visitor` as well.
+     */
+    template <typename Derived>
+    class StaticVisitor : public Visitor
+    {
+        inline Derived &derived() {
+            return static_cast<Derived &>(*this);
+        }
+
+        inline void call(ScopeNode &node) { derived().visitScope(node); }
+        inline void call(TypeNode &node) { derived().visitType(node); }
+        inline void call(TypeCastNode &node) { derived().visitTypeCast(node); }
+        inline void call(VarDeclNode &node) { derived().visitVarDecl(node); }
+        inline void call(VarRefNode &node) { derived().visitVarRef(node); }
+        inline void call(LiteralFloatExprNode &node) { derived().visitLiteralFloatExpr(node); }
+        inline void call(LiteralIntExprNode &node) { derived().visitLiteralIntExpr(node); }
+        inline void call(LiteralBoolExprNode &node) { derived().visitLiteralBoolExpr(node); }
+        inline void call(FunctionCallExprNode &node) { derived().visitFunctionCallExpr(node); }
+        inline void call(VarRefExprNode &node) { derived().visitVarRefExpr(node); }
+        inline void call(BinaryExprNode &node) { derived().visitBinaryExpr(node); }
+        inline void call(UnaryExprNode &node) { derived().visitUnaryExpr(node); }
+        inline void call(VoidExprNode &node) {}
+        inline void call(NullNode &node) { derived().visitNull(node); }
+        inline void call(OperatorNode &node) { derived().visitOperator(node); }
+        inline void call(FunctionDeclNode &node) { derived().visitFunctionDecl(node); }
+        inline void call(ReturnNode &node) { derived().visitReturn(node); }
+        inline void call(IfStatementNode &node) { derived().visitIfStatement(node); }
+
+    public:
+        inline void dispatch(Node &node) {
+            if (!visit(node, [this](auto &concrete) { call(concrete); })) {
+                node.accept(*this);
+            }
+        }
+
+        inline void dispatch(const NodeReference &ref) {
+            assert(ref.has());
+            if (!visit(*ref.node(), ref.type(), [this](auto &concrete) { call(concrete); })) {
+                ref.node()->accept(*this);
+            }
+        }
+    };
+};
+
+#endif
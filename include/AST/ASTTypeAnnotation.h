@@ -0,0 +1,15 @@
+#ifndef ASTTYPEANNOTATION_H
+#define ASTTYPEANNOTATION_H
+
+#pragma once
+
+namespace AST
+{
+    class Node;
+
+    // stores the result type of every expression below the given, fully parsed, node on the
+    // expression itself, children before their parents, so every type is determined only once
+    void annotate_types(Node &root);
+};
+
+#endif
@@ -6,10 +6,10 @@
 #include <type_traits>
 #include <string>
 #include <vector>
-#include <map>
 #include <optional>
 #include <cstdint>
 #include <cassert>
+#include <limits>
 
 namespace AST
 {   
@@ -42,12 +42,13 @@ namespace AST
 
         IntegerSize(uint8_t size, bool is_signed) : size(size), is_signed(is_signed) {}
 
+        // computed in 64 bits, shifting an int overflows for the 32 and 64 bit types
         int64_t get_max_negative_value() const {
-            return is_signed ? -(1 << (size * 8 - 1)) : 0;
+            return is_signed ? std::numeric_limits<int64_t>::min() >> (64 - size * 8) : 0;
         }
 
         uint64_t get_max_positive_value() const {
-            return is_signed ? (1 << (size * 8 - 1)) - 1 : (1 << (size * 8)) - 1;
+            return std::numeric_limits<uint64_t>::max() >> (64 - size * 8 + (is_signed ? 1 : 0));
         }
     };
 
@@ -55,57 +56,67 @@ namespace AST
     uint8_t get_primitive_size(ValueTypePrimitive primitive);
     IntegerSize get_integer_size(ValueTypePrimitive primitive);
 
-    class ValueType {
+    // a type is referred to by its handle, the primitives have fixed handles (their `ValueTypePrimitive`),
+    // every other type is interned in a `ValueTypeCollection` which hands out the handles after them
+    typedef uint32_t vt_handle_t;
 
-        ValueTypeKind kind;
-        ValueTypePrimitive primitive;
+    class ValueType {
 
-        std::optional<std::string> name;
-        std::map<std::string, ValueType> properties;
+        vt_handle_t handle;
 
-        // ComplexType *complex_type
+        // handle 0 is taken by "t_complex" which is not a type on its own
+        static constexpr vt_handle_t unknown_handle = static_cast<vt_handle_t>(ValueTypePrimitive::t_complex);
 
-        ValueType(ValueTypeKind kind, ValueTypePrimitive primitive) : kind(kind), primitive(primitive) {}
+        explicit ValueType(vt_handle_t handle) : handle(handle) {}
 
     public:
+        // the first handle given to an interned type
+        static constexpr vt_handle_t first_interned_handle = static_cast<vt_handle_t>(ValueTypePrimitive::t_void) + 1;
 
         static ValueType make_void() {
             return ValueType(ValueTypePrimitive::t_void);
         }
 
         static ValueType make_unknown() {
-            return ValueType(ValueTypeKind::t_unknown, ValueTypePrimitive::t_void);
+            return ValueType(unknown_handle);
         }
 
         static ValueType void_type() {
             return ValueType(ValueTypePrimitive::t_void);
         }
 
+        static ValueType from_handle(vt_handle_t handle) {
+            return ValueType(handle);
+        }
 
-        ValueType() = default;
-        ValueType(ValueTypePrimitive primitive) : kind(ValueTypeKind::t_primitive), primitive(primitive) {}
+        ValueType() : handle(static_cast<vt_handle_t>(ValueTypePrimitive::t_void)) {}
+        ValueType(ValueTypePrimitive primitive) : handle(static_cast<vt_handle_t>(primitive)) {
+            assert(primitive != ValueTypePrimitive::t_complex && "complex types have to be interned");
+        }
 
-        template<ValueTypeKind K, typename = std::enable_if_t<K == ValueTypeKind::t_class || K == ValueTypeKind::t_struct>>
-        ValueType(ValueTypeKind kind, std::vector<ValueType> properties) : kind(kind) {
-            for (auto& prop : properties) {
-                this->properties[prop.name.value()] = prop;
-            }
+        inline vt_handle_t get_handle() const {
+            return handle;
         }
 
         bool is_primitive() const {
-            return kind == ValueTypeKind::t_primitive;
+            return handle != unknown_handle && handle < first_interned_handle;
+        }
+
+        bool is_unknown() const {
+            return handle == unknown_handle;
+        }
+
+        // classes and structs, their details live in the collection that interned them
+        bool is_interned() const {
+            return handle >= first_interned_handle;
         }
 
         bool is_primitive_of_type(ValueTypePrimitive primitive) const {
-            return is_primitive() && this->primitive == primitive;
+            return is_primitive() && get_primitive_type() == primitive;
         }
 
         bool is_numeric_type() const {
-            if (!is_primitive()) {
-                return false;
-            }
-
-            switch (this->primitive)
+            switch (get_primitive_type())
             {
             case ValueTypePrimitive::t_int8:
             case ValueTypePrimitive::t_int16:
@@ -125,11 +136,7 @@ namespace AST
         }
 
         bool is_floating_type() const {
-            if (!is_primitive()) {
-                return false;
-            }
-
-            switch (this->primitive)
+            switch (get_primitive_type())
             {
             case ValueTypePrimitive::t_float32:
             case ValueTypePrimitive::t_float64:
@@ -141,11 +148,7 @@ namespace AST
         }
 
         bool is_signed_integer() const {
-            if (!is_primitive()) {
-                return false;
-            }
-
-            switch (this->primitive)
+            switch (get_primitive_type())
             {
             case ValueTypePrimitive::t_int8:
             case ValueTypePrimitive::t_int16:
@@ -159,11 +162,7 @@ namespace AST
         }
 
         bool is_unsigned_integer() const {
-            if (!is_primitive()) {
-                return false;
-            }
-
-            switch (this->primitive)
+            switch (get_primitive_type())
             {
             case ValueTypePrimitive::t_uint8:
             case ValueTypePrimitive::t_uint16:
@@ -182,47 +181,27 @@ namespace AST
 
         bool will_fit_into(ValueType other) const;
         
+        // unknown types count as void, interned ones as complex
         inline ValueTypePrimitive get_primitive_type() const {
-            return primitive;
-        }
-
-        bool is_named() const {
-            return name.has_value();
-        }
-
-        // compare two types
-        bool operator==(const ValueType& other) const {
-            if (is_primitive() && other.is_primitive()) {
-                return primitive == other.primitive;
-            }
-
-            assert(false && "Not implemented");
-        }
-
-        std::string get_type_match_signature() const {
             if (is_primitive()) {
-                return get_primitive_name(primitive);
+                return static_cast<ValueTypePrimitive>(handle);
             }
 
-            std::string signature = "{";
-            for (auto it = properties.begin(); it != properties.end(); ++it) {
-                const auto& [name, type] = *it;
-                signature += type.get_type_match_signature();
-                if (std::next(it) != properties.end()) {
-                    signature += ", ";
-                }
-            }
+            return is_unknown() ? ValueTypePrimitive::t_void : ValueTypePrimitive::t_complex;
+        }
 
-            signature += "}";
-            return signature;
+        // types are interned, so the same type always has the same handle
+        bool operator==(const ValueType& other) const {
+            return handle == other.handle;
         }
 
+        // the description of interned types needs their collection, see `ValueTypeCollection::get_type_description`
         std::string get_type_desciption() const {
-            if (is_named()) {
-                return name.value();
+            if (is_primitive()) {
+                return get_primitive_name(get_primitive_type());
             }
 
-            return get_type_match_signature();
+            return "{}";
         }
 
     };
@@ -3,27 +3,58 @@
 
 #pragma once
 
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include "AST/ASTValueType.h"
 
 namespace AST
-{   
-    typedef size_t vt_handle_t;
-    
+{
+    // everything that makes up a class or struct type
+    struct ValueTypeDescriptor {
+        ValueTypeKind kind;
+        std::optional<std::string> name;
+        // ordered by name
+        std::vector<std::pair<std::string, ValueType>> properties;
+    };
+
+    /**
+     * Registry of all class and struct types
+     *
+     * Types are hash consed, interning the same type twice returns the same handle, so
+     * comparing two types never has to look at their properties. Primitive types are
+     * not stored, their handles are fixed (see `ValueType`).
+     */
     class ValueTypeCollection
     {
-        std::vector<ValueType> value_types;
+        std::vector<ValueTypeDescriptor> _descriptors;
+        std::unordered_map<std::string, vt_handle_t> _handles;
 
     public:
 
         ValueTypeCollection();
         ~ValueTypeCollection();
 
-        vt_handle_t push_type(ValueType type);
+        // returns the type with the given kind, name and properties, registering it on first use
+        ValueType intern(ValueTypeDescriptor descriptor);
 
-    private:
+        const ValueTypeDescriptor &descriptor(ValueType type) const;
+
+        ValueTypeKind kind(ValueType type) const;
 
+        std::string get_type_description(ValueType type) const;
+
+        // the number of interned types
+        inline size_t size() const {
+            return _descriptors.size();
+        }
+
+    private:
+        // the hash consing key, built from the handles of the properties which are unique themselves
+        static std::string make_key(const ValueTypeDescriptor &descriptor);
     };
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -17,8 +17,17 @@ namespace AST
     class ExprNode : public Node
     {
     public:
+        // the type stored by `annotate_types`, expressions are not changed after it ran
+        std::optional<ValueType> annotated_type;
+
         // returns the type this expression will return
-        virtual ValueType result_type() const {
+        inline ValueType result_type() const {
+            return annotated_type ? *annotated_type : resolve_type();
+        }
+
+        // determines the type from the node and its children, which for a whole
+        // tree recurses into every subexpression, use `result_type` instead
+        virtual ValueType resolve_type() const {
             return ValueType::void_type();
         }
 
@@ -43,7 +52,7 @@ namespace AST
             return "void";
         }
 
-        ValueType result_type() const override {
+        ValueType resolve_type() const override {
             return ValueType::void_type();
         }
 
@@ -64,7 +73,7 @@ namespace AST
 
         ~VarRefExprNode() {};
 
-        ValueType result_type() const override {
+        ValueType resolve_type() const override {
             assert(var_ref->decl);
             return var_ref->decl->type_node()->type;
         }
@@ -93,7 +102,7 @@ namespace AST
         ~FunctionCallExprNode() {}
 
         const std::string node_description() override {
-            std::string desc = "call " + token_function_name.value() + "(";
+            std::string desc = "call " + std::string(token_function_name.value()) + "(";
 
             for (auto arg : arguments) {
                 desc += arg->node_description() + ", ";
@@ -123,7 +132,7 @@ namespace AST
         {};
         ~BinaryExprNode() {}
 
-        ValueType result_type() const override;
+        ValueType resolve_type() const override;
 
         const std::string lhs_node_description() {
             return lhs ? lhs->node_description() : "[undefined]";
@@ -134,7 +143,7 @@ namespace AST
         }
 
         const std::string node_description() override {
-            return "binexp<" + result_type().get_type_desciption() + ">(" + lhs_node_description() + " " + op_node->token_literal.value() + " " + rhs_node_description() + ")";
+            return "binexp<" + result_type().get_type_desciption() + ">(" + lhs_node_description() + " " + std::string(op_node->token_literal.value()) + " " + rhs_node_description() + ")";
         }
 
         void accept(Visitor& visitor) override {
@@ -151,14 +160,24 @@ namespace AST
 
         ExprNode *expr;
 
-        UnaryExprNode(TokenReference token_operator, ExprNode *expr) :
-            token_operator(token_operator), expr(expr)
+        // the operator follows the operand, like in "$i++"
+        bool is_postfix = false;
+
+        UnaryExprNode(TokenReference token_operator, ExprNode *expr, bool is_postfix = false) :
+            token_operator(token_operator), expr(expr), is_postfix(is_postfix)
         {};
 
         ~UnaryExprNode() {}
 
+        ValueType resolve_type() const override {
+            return expr ? expr->result_type() : ValueType::void_type();
+        }
+
         const std::string node_description() override {
-            return "unexp(" + token_operator.value() + expr->node_description() + ")";
+            if (is_postfix) {
+                return "unexp(" + expr->node_description() + std::string(token_operator.value()) + ")";
+            }
+            return "unexp(" + std::string(token_operator.value()) + expr->node_description() + ")";
         }
 
         void accept(Visitor& visitor) override {
@@ -31,7 +31,7 @@ namespace AST
 
         const std::string func_name() {
             if (name_token.has_value()) {
-                return name_token.value().value();
+                return std::string(name_token.value().value());
             }
 
             return "[anonymous]";
@@ -7,8 +7,15 @@
 #include "ExprNode.h"
 #include "../Lexer.h"
 
+#include <optional>
+#include <string_view>
+
 namespace AST 
 {
+    // wide enough for the values of all integer types and their range checks
+    __extension__ typedef __int128 int128_t;
+    __extension__ typedef unsigned __int128 uint128_t;
+
     class LiteralPrimitiveExprNode : public ExprNode
     {
     public:
@@ -32,7 +39,11 @@ namespace AST
         };
 
         const std::string effective_token_literal_value() const {
-            return override_literal_value.value_or(token_literal.value());
+            if (override_literal_value.has_value()) {
+                return override_literal_value.value();
+            }
+
+            return std::string(token_literal.value());
         }
 
         const std::string node_description() override {
@@ -45,30 +56,44 @@ namespace AST
     public:
         static constexpr NodeType node_type = NodeType::n_literal_float;
         
+        // the literal decoded once for both precisions, each from the decimal
+        // digits, so a float is not rounded twice by going through the double
+        double value_f64 = 0.0;
+        float value_f32 = 0.0f;
+
         LiteralFloatExprNode(TokenReference token) :
             LiteralPrimitiveExprNode(token)
-        {};
+        {
+            decode();
+        };
 
         LiteralFloatExprNode(TokenReference token, ValueTypePrimitive expected) :
             LiteralPrimitiveExprNode(token, expected)
         {
             assert(expected == ValueTypePrimitive::t_float64 || expected == ValueTypePrimitive::t_float32);
+            decode();
         };
 
+        // replaces the literal value of the token, the value is decoded again
+        void set_literal_value(const std::string &literal) {
+            override_literal_value.emplace(literal);
+            decode();
+        }
+
         ValueTypePrimitive get_effective_primitive_type() const {
             return expected_primitive_type.value_or(
                 is_double_precision() ? ValueTypePrimitive::t_float64 : ValueTypePrimitive::t_float32
             );
         }
 
-        ValueType result_type() const override {
+        ValueType resolve_type() const override {
             return ValueType(get_effective_primitive_type());
         }
 
         // floats literals have to end with a "f" to be considered a float
         // everything else is considered a double
         bool is_double_precision() const {
-            return effective_token_literal_value().back() != 'f';
+            return double_precision;
         }
 
         void accept(Visitor& visitor) override {
@@ -86,14 +111,18 @@ namespace AST
 
         float float_value() const {
             assert(get_effective_primitive_type() == ValueTypePrimitive::t_float32);
-            // cut off the "f" at the end
-            return std::stof(get_fvalue_string());
+            return value_f32;
         }
 
         double double_value() const {
             assert(get_effective_primitive_type() == ValueTypePrimitive::t_float64);
-            return std::stod(get_fvalue_string());
+            return value_f64;
         }
+
+    private:
+        bool double_precision = true;
+
+        void decode();
     };
     
     class LiteralIntExprNode : public LiteralPrimitiveExprNode
@@ -101,9 +130,17 @@ namespace AST
     public:
         static constexpr NodeType node_type = NodeType::n_literal_int;
 
+        // the literal decoded once, 128 bits hold every value of every integer type with room
+        // to spare, so range checks are plain comparisons. `is_decoded` is false if the literal
+        // is not a whole number or does not even fit into 128 bits
+        int128_t value = 0;
+        bool is_decoded = false;
+
         LiteralIntExprNode(TokenReference token) :
             LiteralPrimitiveExprNode(token)
-        {};
+        {
+            decode();
+        };
 
         LiteralIntExprNode(TokenReference token, ValueTypePrimitive expected) :
             LiteralPrimitiveExprNode(token, expected)
@@ -118,9 +155,20 @@ namespace AST
                 expected == ValueTypePrimitive::t_uint32 ||
                 expected == ValueTypePrimitive::t_uint64
             );
+            decode();
         };
 
-        ValueType result_type() const override {
+        // replaces the literal value of the token, the value is decoded again
+        void set_literal_value(const std::string &literal) {
+            override_literal_value.emplace(literal);
+            decode();
+        }
+
+        // decodes a decimal integer with an optional leading "-", returns nothing
+        // if it is not one or does not fit into 128 bits
+        static std::optional<int128_t> decode_literal(std::string_view literal);
+
+        ValueType resolve_type() const override {
             return ValueType(expected_primitive_type.value_or(ValueTypePrimitive::t_int32));
         }
 
@@ -128,37 +176,41 @@ namespace AST
             visitor.visitLiteralIntExpr(*this);
         }
 
+        // the value truncated to the type, like a conversion in C
         int8_t int8_value() const {
-            return std::stoi(effective_token_literal_value());
+            return static_cast<int8_t>(value);
         }
 
         int16_t int16_value() const {
-            return std::stoi(effective_token_literal_value());
+            return static_cast<int16_t>(value);
         }
 
         int32_t int32_value() const {
-            return std::stoi(effective_token_literal_value());
+            return static_cast<int32_t>(value);
         }
 
         int64_t int64_value() const {
-            return std::stoll(effective_token_literal_value());
+            return static_cast<int64_t>(value);
         }
 
         uint8_t uint8_value() const {
-            return std::stoul(effective_token_literal_value());
+            return static_cast<uint8_t>(value);
         }
 
         uint16_t uint16_value() const {
-            return std::stoul(effective_token_literal_value());
+            return static_cast<uint16_t>(value);
         }
 
         uint32_t uint32_value() const {
-            return std::stoul(effective_token_literal_value());
+            return static_cast<uint32_t>(value);
         }
 
         uint64_t uint64_value() const {
-            return std::stoull(effective_token_literal_value());
+            return static_cast<uint64_t>(value);
         }
+
+    private:
+        void decode();
     };
 
     class LiteralBoolExprNode : public LiteralPrimitiveExprNode
@@ -170,7 +222,16 @@ namespace AST
             LiteralPrimitiveExprNode(token)
         {};
 
-        ValueType result_type() const override {
+        // replaces the literal value of the token, "true" or "false"
+        void set_literal_value(const std::string &literal) {
+            override_literal_value.emplace(literal);
+        }
+
+        bool bool_value() const {
+            return effective_token_literal_value() == "true";
+        }
+
+        ValueType resolve_type() const override {
             return ValueType(ValueTypePrimitive::t_bool);
         }
 
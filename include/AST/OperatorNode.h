@@ -26,7 +26,7 @@ namespace AST
         ~OperatorNode() {};
 
         const std::string node_description() override {
-            return "operator<" + token_literal.value() + ">";
+            return "operator<" + std::string(token_literal.value()) + ">";
         }
 
         void accept(Visitor& visitor) override {
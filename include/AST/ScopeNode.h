@@ -4,6 +4,7 @@
 #pragma once
 
 #include "ASTNode.h"
+#include "../SymbolTable.h"
 
 #include <unordered_map>
 
@@ -13,7 +14,7 @@ namespace AST
 
     class ScopeNode : public Node
     {
-        std::unordered_map<std::string, VarDeclNode *> _declared_variables;
+        std::unordered_map<symbol_t, VarDeclNode *> _declared_variables;
 
     public:
         ScopeNode *parent_ptr = nullptr;
@@ -64,9 +65,9 @@ namespace AST
 
         void add_vardecl(VarDeclNode &vardecl);
 
-        bool is_varname_taken(const std::string &varname) const;
+        bool is_symbol_taken(symbol_t symbol) const;
 
-        VarDeclNode *find_vardecl_by_name(const std::string &varname) const;
+        VarDeclNode *find_vardecl_by_symbol(symbol_t symbol) const;
 
     private:
 
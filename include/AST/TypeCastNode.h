@@ -25,7 +25,7 @@ namespace AST
             expr(expr)
         {}
 
-        ValueType result_type() const override {
+        ValueType resolve_type() const override {
             return cast_to;
         }
 
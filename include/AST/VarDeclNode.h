@@ -28,8 +28,11 @@ namespace AST
         // the name of variable without the $ prefix
         std::string symbol_name;
 
+        // the interned symbol of the variable name
+        const symbol_t symbol;
+
         VarDeclNode(TokenReference token_varname, TypeNode *type) : 
-            _type_node(type), token_varname(token_varname)
+            _type_node(type), token_varname(token_varname), symbol(token_varname.symbol())
         {
             symbol_name = token_varname.value().substr(1);
         };
@@ -38,7 +41,7 @@ namespace AST
 
         static constexpr NodeType node_type = NodeType::n_vardecl;
 
-        const std::string &name_full() const {
+        std::string_view name_full() const {
             return token_varname.value();
         }
 
@@ -28,7 +28,7 @@ namespace AST
         
         const std::string node_description() override {
 
-            return "varref<"+ decl->type_node()->node_description() +">(" + decl->name_full() + ")";
+            return "varref<"+ decl->type_node()->node_description() +">(" + std::string(decl->name_full()) + ")";
         }
 
         void accept(Visitor& visitor) override {
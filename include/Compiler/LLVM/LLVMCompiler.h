@@ -5,6 +5,10 @@
 
 #include "AST/ASTBundle.h"
 #include "AST/ASTVisitor.h"
+#include "AST/ASTStaticVisitor.h"
+#include "AST/ASTCompact.h"
+#include "Compiler/LLVM/LLVMObjectCache.h"
+#include "ThreadPool.h"
 
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/STLExtras.h"
@@ -27,31 +31,125 @@
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/TargetParser/Host.h"
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <stack>
 #include <unordered_map>
 
+// path of the runtime archive executables are linked against, set by the build
+#ifndef ECHO_RUNTIME_ARCHIVE
+#define ECHO_RUNTIME_ARCHIVE "libecho_runtime.a"
+#endif
+
 namespace AST {
     class VarDeclNode;
 };
 
-class LLVMCompiler : public AST::Visitor
+namespace llvm::orc {
+    class LLLazyJIT;
+    class JITDylib;
+    class JITTargetMachineBuilder;
+};
+
+// final so the static dispatch calls the visit methods directly
+class LLVMCompiler final : public AST::StaticVisitor<LLVMCompiler>
 {
     std::unique_ptr<llvm::LLVMContext> llvm_context;
     std::unique_ptr<llvm::IRBuilder<>> llvm_builder;
     std::unique_ptr<llvm::Module> llvm_module;
     
     std::stack<llvm::Value *> value_stack;
-    std::unordered_map<AST::VarDeclNode *, llvm::AllocaInst *> var_map;
+
+    // the binding of every declared variable, see `emit_var_binding`
+    std::unordered_map<AST::VarDeclNode *, llvm::Value *> var_map;
+
+    // declared functions by the symbol of their name, symbols are bundle wide
+    std::unordered_map<symbol_t, llvm::Function *> function_map;
 
 public:
+    // drives both the IR pass pipeline and the machine code generation of the JIT and object files
+    enum class OptLevel {
+        O0,
+        O1,
+        O2,
+        O3,
+        Os,
+    };
+
+    // parses a command line flag like "-O2", returns nothing if it is not an optimization flag
+    static std::optional<OptLevel> parse_opt_level(std::string_view flag);
+
+private:
+    // created on the first run and kept alive, every run gets its own dylib
+    std::unique_ptr<llvm::orc::LLLazyJIT> jit;
+    // the JIT is recreated when the optimization level or the target changed since it was created
+    OptLevel jit_opt_level = OptLevel::O0;
+    std::string jit_cpu;
+    std::string jit_features;
+    size_t jit_run_count = 0;
+
+public:
+    // a finished llvm module together with the context it lives in, units
+    // never share a context so they can be optimized and emitted concurrently
+    struct CompiledUnit {
+        std::unique_ptr<llvm::LLVMContext> context;
+        std::unique_ptr<llvm::Module> module;
+    };
+
+    // the finished units, already optimized and, with `profile_generate` set, instrumented
+    std::vector<CompiledUnit> units;
+
+    // units are optimized at this level when they are finished
+    OptLevel opt_level = OptLevel::O0;
+
+    // the CPU and comma separated features ("+avx2,-avx512f") code is generated for,
+    // when both are empty the ones of the host are used, like -march=native. A cpu without
+    // features uses the default features of that cpu, not the ones of the host
+    std::string target_cpu;
+    std::string target_features;
+
+    // when set the compile functions first look for the objects of the bundle in the cache
+    // and skip code generation if they are found, freshly emitted objects are stored in it
+    LLVMObjectCache *object_cache = nullptr;
+
+    // identifies the compiler in the cache key, the code generation changes far more often than
+    // we would bump a version number, so by default this is the id generated by every build
+    std::string build_id;
+
+    // the object files of the units, emitted from `units` or loaded from the cache
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects;
+
+    // executables are linked by invoking the C compiler driver with the objects and the runtime archive
+    std::string linker = "cc";
+    std::string runtime_archive = ECHO_RUNTIME_ARCHIVE;
+    bool static_link = false;
+
+    // profile guided optimization, with `profile_generate` set the units are instrumented and the
+    // linked executable writes its raw profile (.profraw) to that path when it exits, the counters
+    // are maintained by the profile runtime, so the linker has to be a driver that ships it (clang)
+    std::string profile_generate;
+    // merged profile (.profdata, see `llvm-profdata merge`) of an instrumented build of the same sources,
+    // the pipeline derives branch weights, inlining and block layout from it
+    std::string profile_use;
+
     LLVMCompiler();
     ~LLVMCompiler();
 
     void compile_bundle(const AST::Bundle &bundle);
 
+    // same as compile_bundle but generates the code from the compact trees of the files, which only
+    // exist when they were parsed with `ModuleParser::lower_compact`, throws for a file without one.
+    // The node trees are not used, so they can be released upfront (see `Module::release_nodes`)
+    void compile_bundle_compact(const AST::Bundle &bundle);
+
+    // generates one unit per AST module on the pool, the top level code of every module
+    // goes into an init function which are called in order by `main` in a unit of its own
+    void compile_bundle_parallel(const AST::Bundle &bundle, ThreadPool &pool);
+
     void visitScope(AST::ScopeNode &node);
     void visitType(AST::TypeNode &node);
     void visitTypeCast(AST::TypeCastNode &node);
@@ -72,13 +170,106 @@ public:
 
     llvm::Type *get_llvm_type(AST::ValueTypePrimitive type);
 
-    void optimize();
     void printIR(bool toFile);
-    void run_code();
-    void make_exec(std::string executable_name);
+    // run_code_tiered recompiles a function at `tier_up_level` once it has been called this often
+    uint64_t tier_up_threshold = 1000;
+    OptLevel tier_up_level = OptLevel::O3;
+
+    // compiles the functions of all units lazily on their first call and runs main,
+    // with an object cache the units are compiled upfront so their objects can be stored
+    // returns the exit code of the program, instrumented programs cannot be run in the JIT
+    int run_code();
+
+    // like run_code, but functions start out unoptimized with fast instruction selection and a call
+    // counter, hot functions are optimized on a background thread and swapped in while the program runs
+    int run_code_tiered();
+
+    // emits the objects of all units and links them with the runtime into an executable at the given path
+    bool make_exec(const std::string &output_path, ThreadPool *pool = nullptr);
+
+    // emits the objects of all units unless they have been loaded from the cache
+    void emit_objects(ThreadPool *pool = nullptr);
+
+    // hashes the sources of the bundle together with everything else the generated code depends on,
+    // `mode` distinguishes the compile functions as they split the code into different units
+    std::string object_cache_key(const AST::Bundle &bundle, std::string_view mode) const;
 
 private:
+    // function attribute marking the functions of the program, as opposed to the entry and runtime functions
+    static constexpr const char *echo_function_attribute = "echo-function";
+
+    llvm::orc::LLLazyJIT &get_jit();
+
+    // a new dylib that resolves missing symbols from the host process
+    static llvm::orc::JITDylib *create_run_dylib(llvm::orc::LLLazyJIT &lazy_jit, const std::string &name);
+
+    // the JIT and bookkeeping of a tiered run, shared with the background recompilations
+    struct TieredState;
+    std::shared_ptr<TieredState> tiered;
+
+    // called from the generated code when a function becomes hot
+    static void tier_up_callback(TieredState *state, uint32_t function);
+    void tier_up(TieredState &state, uint32_t function);
+
+    // describes the target machine for the configured CPU and features at the given optimization level,
+    // used for the JIT and for the object files alike
+    llvm::orc::JITTargetMachineBuilder make_target_builder(OptLevel level) const;
+
+    // the module, builder and runtime declarations every unit starts with
+    void begin_compile(const std::string &unit_name = "echo_module");
+
+    // creates `int main(int argc, char **argv)` in the current module and starts inserting into it
+    void begin_main_function();
+    // returns from main with the exit code of the runtime
+    void end_main_function();
+
+    bool link_executable(const std::string &output_path, const std::vector<std::string> &object_paths);
+
+    // verifies (debug builds only) and optimizes the current module and moves it into `units`
+    void finish_unit();
+
+    // creates the prototype of the function or returns it if it has already been declared
+    llvm::Function *declare_function(AST::FunctionDeclNode &node);
+
+    void compile_module_unit(const AST::Bundle &bundle, AST::Module &module);
+
+    // runs `task` for every unit, on the pool if one is given
+    void for_each_unit(ThreadPool *pool, const std::function<void(CompiledUnit &)> &task);
+
+    // key of the bundle being compiled, set when it was not found in the cache
+    std::string pending_cache_key;
+
+    // resets the compiler output and loads the objects of the bundle from the cache if possible
+    bool load_cached_objects(const AST::Bundle &bundle, std::string_view mode);
+
+    void optimize_module(llvm::Module &module, OptLevel level);
+    std::unique_ptr<llvm::MemoryBuffer> emit_object(llvm::Module &module, OptLevel level);
+
+    // emitters shared by the node visitor and the compact tree
+    llvm::Value *emit_cast(llvm::Value *value, AST::ValueTypePrimitive from, AST::ValueTypePrimitive to);
+    llvm::Value *emit_binary(Token::Type op, llvm::Value *left, AST::ValueTypePrimitive left_type, llvm::Value *right, AST::ValueTypePrimitive right_type);
+    llvm::Value *emit_unary(Token::Type op, llvm::Value *value);
+    llvm::Value *emit_store_conversion(llvm::Value *value, llvm::Type *type);
+    // the AST type tells signed from unsigned integers, calls whose type is not known yet are printed signed
+    void emit_echo(llvm::Value *value, AST::ValueTypePrimitive type);
+    llvm::Function *emit_function_prototype(const std::string &name, AST::ValueTypePrimitive return_type, const std::vector<AST::ValueTypePrimitive> &arg_types);
+    // starts inserting into the entry block of the function and names its arguments
+    void emit_function_entry(llvm::Function *func, const std::vector<llvm::StringRef> &arg_names);
+    // one block of an if statement, an else block has no condition. The condition is emitted
+    // into the current block, both paths join in a merge block where the insertion continues
+    void emit_if_block(const std::function<llvm::Value *()> &condition, const std::function<void()> &body);
+
+    // reassigning a variable declares a new one, so a declaration with an initializer is bound
+    // directly to the SSA value of it, only declarations without one get a stack slot (alloca)
+    llvm::Value *emit_var_binding(llvm::StringRef name, llvm::Type *type, llvm::Value *init);
+    // the current value of a variable binding
+    llvm::Value *emit_var_load(llvm::Value *binding);
 
+    // compact tree code generation, `compact_vars` maps vardecl indices of the current tree to their bindings
+    std::vector<llvm::Value *> compact_vars;
+    void compact_function(const AST::CompactTree &tree, const SymbolTable &symbols, AST::cnode_t node);
+    void compact_statement(const AST::CompactTree &tree, const SymbolTable &symbols, AST::cnode_t node);
+    llvm::Value *compact_expr(const AST::CompactTree &tree, AST::cnode_t node);
 };
 
 #endif
\ No newline at end of file
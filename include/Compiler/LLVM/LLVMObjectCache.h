@@ -0,0 +1,44 @@
+#ifndef LLVMOBJECTCACHE_H
+#define LLVMOBJECTCACHE_H
+
+#pragma once
+
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Content addressed cache of compiled object files on disk
+ *
+ * An entry holds the object files of all units of a compiled bundle and is stored
+ * under a key that hashes everything the machine code depends on (see `LLVMCompiler::object_cache_key`).
+ * Every entry is a directory `<key>/` with the objects `0.o`, `1.o` ... in unit order.
+ * It is written under a temporary name and renamed when complete, so concurrent
+ * runs never read a half written entry.
+ */
+class LLVMObjectCache
+{
+    std::filesystem::path _directory;
+
+public:
+    // relative directories are resolved right away, the staging directories
+    // of llvm would otherwise end up in the temp directory of the system
+    explicit LLVMObjectCache(const std::filesystem::path &directory) :
+        _directory(std::filesystem::absolute(directory))
+    {};
+
+    const std::filesystem::path &directory() const {
+        return _directory;
+    }
+
+    // returns the objects stored under the key, empty if there is no entry
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> load(const std::string &key) const;
+
+    // stores the objects under the key, returns false if the entry could not be written
+    bool store(const std::string &key, const std::vector<std::unique_ptr<llvm::MemoryBuffer>> &objects) const;
+};
+
+#endif
@@ -7,8 +7,10 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <string_view>
 
 #include "Token.h"
+#include "LexerSIMD.h"
 #include "AST/ASTOps.h"
 
 #define MHP_VOCAB_LB '\n'
@@ -28,23 +30,26 @@ struct LexerCursor
     size_t char_offset;
     size_t end_of_line_offset;
 
-    const std::string &input;
+    const std::string_view input;
 
-    LexerCursor(const std::string &input) : 
-        line(1), char_offset(1), input(input), it(input.begin())
+    // the id of the input in the token collection, tokens reference their value through it
+    uint32_t source;
+
+    LexerCursor(std::string_view input, uint32_t source = 0) : 
+        line(1), char_offset(1), input(input), source(source), it(input.begin())
     {
         determine_end_of_line();
     }
 
-    inline const std::string::const_iterator begin() const {
+    inline std::string_view::const_iterator begin() const {
         return input.begin();
     }
 
-    inline const std::string::const_iterator end() const {
+    inline std::string_view::const_iterator end() const {
         return input.end();
     }
 
-    inline const std::string::const_iterator end_of_line() const {
+    inline std::string_view::const_iterator end_of_line() const {
         return input.begin() + end_of_line_offset;
     }
 
@@ -60,10 +65,29 @@ struct LexerCursor
         return (it + offset != input.end()) ? *(it + offset) : '\0';
     }
 
-    inline const std::string::const_iterator current() const {
+    inline std::string_view::const_iterator current() const {
         return it;
     }
 
+    // byte offset of the cursor in the input
+    inline size_t offset() const {
+        return it - input.begin();
+    }
+
+    // byte offset of the given iterator in the input
+    inline size_t offset(std::string_view::const_iterator pos) const {
+        return pos - input.begin();
+    }
+
+    // raw pointers to the current position and the end of the input, used by the block scanners
+    inline const char *data() const {
+        return input.data() + (it - input.begin());
+    }
+
+    inline const char *data_end() const {
+        return input.data() + input.size();
+    }
+
     void reset();
 
     inline void determine_end_of_line() {
@@ -96,16 +120,31 @@ struct LexerCursor
         }
     }
 
-    inline void skip_formatting() {
-        while (is_formatting() && !is_eof()) {
-            skip();
+    // moves the cursor forward to the given position, instead of checking every byte
+    // the line and column counters are updated in bulk based on the newlines in between
+    inline void skip_to(const char *target) {
+        const char *start = data();
+        const char *last_newline = nullptr;
+        const auto newlines = LexerSIMD::count_newlines(start, target, last_newline);
+
+        it += target - start;
+
+        if (newlines == 0) {
+            char_offset += target - start;
+            return;
         }
+
+        line += newlines;
+        char_offset = target - last_newline;
+        determine_end_of_line();
+    }
+
+    inline void skip_formatting() {
+        skip_to(LexerSIMD::skip_formatting(data(), data_end()));
     }
 
     inline void skip_until(char c) {
-        while (peek() != c && !is_eof()) {
-            skip();
-        }
+        skip_to(LexerSIMD::find_char(data(), data_end(), c));
     }
 
     inline void skip_until_nl() {
@@ -132,20 +171,20 @@ struct LexerCursor
 
     // returns true if the input at the current cursor position
     // matches the given string
-    inline bool begins_with(const std::string &str) {
-        return input.compare(it - input.begin(), str.size(), str) == 0;
-    }
-
     inline bool begins_with(const char *str) {
         return input.compare(it - input.begin(), strlen(str), str) == 0;
     }
 
+    inline bool begins_with(std::string_view str) {
+        return input.compare(it - input.begin(), str.size(), str) == 0;
+    }
+
     inline bool is_quote() {
         return peek() == MHP_VOCAB_DUBQUOTE || peek() == MHP_VOCAB_SNGQUOTE;
     }
 
     inline bool is_formatting() {
-        return peek() == MHP_VOCAB_SPACE || peek() == MHP_VOCAB_TAB || peek() == MHP_VOCAB_LB;
+        return LexerSIMD::is_formatting_char(peek());
     }
 
     // to be able to handle expressions properly we need to have some rule set of what is a valid
@@ -170,19 +209,35 @@ struct LexerCursor
 
     // returns a string giving the user some context 
     // of where in the code the iterator currently is, will never go beyond its current line
-    std::string get_code_sample(const std::string::const_iterator it, const uint32_t start_offset = 0, const uint32_t end_offset = 20) const;
+    std::string get_code_sample(const std::string_view::const_iterator it, const uint32_t start_offset = 0, const uint32_t end_offset = 20) const;
 
 private:
-    std::string::const_iterator it;
+    std::string_view::const_iterator it;
 };
 
 namespace LexerFunction
 {
+    // the different kinds of lexer functions, used to compile the
+    // function tree into a table without having to go through virtual calls
+    enum class Kind : uint8_t {
+        char_token,
+        string_token,
+        numeric_literal,
+        hex_literal,
+        string_literal,
+        variable_name,
+        single_line_comment,
+        multi_line_comment,
+        identifier
+    };
+
     class Base 
     {
     public:
         virtual ~Base() {};
 
+        virtual Kind kind() const = 0;
+
         // the priority of the lexer function, wil be used to sort
         // all considered lexer functions.
         virtual int priority() const = 0;
@@ -203,11 +258,19 @@ namespace LexerFunction
 
         TreeNode(const std::string &prefix) : prefix(prefix) {}
         TreeNode() = default;
+
+        // follows the input at the cursor as far down the tree as possible
+        // and returns the deepest node reached, the depth is written to `depth`
+        const TreeNode *find_deepest(const LexerCursor &cursor, size_t &depth) const;
     };
 
     class CharToken : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::char_token;
+        }
+
         const char lit;
         const Token::Type type;
 
@@ -227,6 +290,10 @@ namespace LexerFunction
     class StringToken : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::string_token;
+        }
+
         const std::string lit;
         const Token::Type type;
 
@@ -243,6 +310,10 @@ namespace LexerFunction
     class NumericLiteral : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::numeric_literal;
+        }
+
         int priority() const override {
             return 10; // a negative number literal should be considered before the neg operator
         }
@@ -254,6 +325,10 @@ namespace LexerFunction
     class HexLiteral : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::hex_literal;
+        }
+
         int priority() const override {
             return 20;
         }
@@ -265,6 +340,10 @@ namespace LexerFunction
     class StringLiteral : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::string_literal;
+        }
+
         int priority() const override {
             return 5;
         }
@@ -276,6 +355,10 @@ namespace LexerFunction
     class VariableName : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::variable_name;
+        }
+
         int priority() const override {
             return 100;
         }
@@ -287,6 +370,10 @@ namespace LexerFunction
     class SingleLineComment : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::single_line_comment;
+        }
+
         int priority() const override {
             return 999;
         }
@@ -298,6 +385,10 @@ namespace LexerFunction
     class MultiLineComment : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::multi_line_comment;
+        }
+
         int priority() const override {
             return 999;
         }
@@ -309,6 +400,10 @@ namespace LexerFunction
     class Identifier : public Base
     {
     public:
+        Kind kind() const override {
+            return Kind::identifier;
+        }
+
         int priority() const override {
             return -1;
         }
@@ -316,12 +411,81 @@ namespace LexerFunction
         const std::vector<std::string> must_match() const override;
         bool parse(TokenCollection &tokens, LexerCursor &cursor) const override;
     };
+
+    // a flat state machine compiled from a function tree, every tree node becomes a state
+    // with a 256 entry jump table for the next input byte and a list of candidates
+    // (the functions of that node) sorted by priority
+    class Table
+    {
+    public:
+        struct Candidate {
+            Kind kind;
+            Token::Type type;
+            int priority;
+            uint32_t literal_offset;
+            uint32_t literal_size;
+        };
+
+        struct State {
+            uint32_t candidates_begin;
+            uint32_t candidates_end;
+        };
+
+        // state 0 is always the root, it is never the target of a transition
+        // so 0 can be used to mark "no transition"
+        static constexpr uint16_t root_state = 0;
+
+        Table(const TreeNode &root);
+
+        inline uint16_t transition(uint16_t state, char c) const {
+            return _transitions[static_cast<size_t>(state) * 256 + static_cast<unsigned char>(c)];
+        }
+
+        // follows the input at the cursor as far as possible, same as TreeNode::find_deepest
+        uint16_t find_deepest(const LexerCursor &cursor, size_t &depth) const;
+
+        inline const Candidate *candidates_begin(uint16_t state) const {
+            return _candidates.data() + _states[state].candidates_begin;
+        }
+
+        inline const Candidate *candidates_end(uint16_t state) const {
+            return _candidates.data() + _states[state].candidates_end;
+        }
+
+        inline bool has_candidates(uint16_t state) const {
+            return _states[state].candidates_begin != _states[state].candidates_end;
+        }
+
+        inline std::string_view literal(const Candidate &candidate) const {
+            return std::string_view(_literals).substr(candidate.literal_offset, candidate.literal_size);
+        }
+
+        inline size_t state_count() const {
+            return _states.size();
+        }
+
+    private:
+        std::vector<uint16_t> _transitions;
+        std::vector<State> _states;
+        std::vector<Candidate> _candidates;
+        std::string _literals;
+    };
 }
 
 class Lexer 
 {
     using FunctionList = std::vector<std::unique_ptr<LexerFunction::Base>>;
 
+    // the built-in lexer functions and the prefix tree dispatching to them
+    // both are built exactly once in the constructor and never modified afterwards
+    // so a single lexer can be reused for any number of files
+    FunctionList _functions;
+    std::unique_ptr<LexerFunction::TreeNode> _function_tree;
+
+    // the function tree compiled into a state machine, this is what 
+    // is actually used when tokenizing
+    std::unique_ptr<LexerFunction::Table> _function_table;
+
     // template<size_t N>
     // struct CSXStrLiteral {
     //     constexpr CSXStrLiteral(const char (&str)[N]) {
@@ -375,13 +539,20 @@ public:
         {}
     };
 
-    Lexer() {}
+    Lexer();
     ~Lexer() {}
 
     /**
-     * Executes the given function list
+     * Executes the built-in lexer functions, the optional overlay tree holds
+     * additional functions (custom operators) that are only valid for the current input
      */
-    void execute_functions(FunctionList &functions, TokenCollection &tokens, LexerCursor &cursor);
+    void execute_functions(const LexerFunction::TreeNode *overlay_tree, TokenCollection &tokens, LexerCursor &cursor) const;
+
+    /**
+     * Same as execute_functions but runs the compiled state machine instead of walking 
+     * the function tree and calling the virtual parse functions. Both produce exactly the same tokens.
+     */
+    void execute_table(const LexerFunction::Table *overlay_table, TokenCollection &tokens, LexerCursor &cursor) const;
 
 
     // /**
@@ -502,14 +673,21 @@ public:
     // bool parse_ml_comment(TokenCollection &tokens, LexerCursor &cursor);
 
     /**
-     * Parses the given input string into a collection of tokens
+     * Parses the given input string into a collection of tokens, the input is 
+     * copied into the collection so it does not have to outlive it
+     */
+    void tokenize(TokenCollection &tokens, const std::string &input, const AST::OperatorRegistry *op_registry = nullptr) const;
+
+    /**
+     * Same as tokenize but without copying the input, the tokens reference 
+     * the given buffer directly so it has to outlive the token collection
      */
-    void tokenize(TokenCollection &tokens, const std::string &input, const AST::OperatorRegistry *op_registry = nullptr);
+    void tokenize_view(TokenCollection &tokens, std::string_view input, const AST::OperatorRegistry *op_registry = nullptr) const;
 
     /**
      * Tokenizer prepass (used to identify custom operators)
      */
-    void tokenize_prepass_operators(const std::string &input, AST::OperatorRegistry &op_registry);
+    void tokenize_prepass_operators(std::string_view input, AST::OperatorRegistry &op_registry) const;
 
 private:
 };
@@ -0,0 +1,177 @@
+#ifndef LEXERSIMD_H
+#define LEXERSIMD_H
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Block wise scanning helpers for the lexer cursor
+ *
+ * All functions take a [begin, end) byte range and return a pointer to the first byte
+ * that ends the run (or `end`). Full blocks of 32 (AVX2) or 16 (SSE2) bytes are checked at once
+ * using a byte mask, the remaining tail is handled by the scalar version which is also used
+ * on platforms without SSE2 / AVX2.
+ */
+namespace LexerSIMD
+{
+    constexpr bool is_formatting_char(char c) {
+        return c == ' ' || c == '\t' || c == '\n';
+    }
+
+    constexpr bool is_varname_char(char c) {
+        return (c >= 'a' && c <= 'z') ||
+               (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') ||
+               (c == '_');
+    }
+
+#if defined(__AVX2__)
+    #define ECHO_LEXER_SIMD 1
+    using block_t = __m256i;
+    constexpr size_t block_size = 32;
+    constexpr uint32_t block_full_mask = 0xFFFFFFFF;
+
+    inline block_t block_load(const char *p) { return _mm256_loadu_si256(reinterpret_cast<const block_t *>(p)); }
+    inline block_t block_splat(char c) { return _mm256_set1_epi8(c); }
+    inline block_t block_eq(block_t a, block_t b) { return _mm256_cmpeq_epi8(a, b); }
+    inline block_t block_gt(block_t a, block_t b) { return _mm256_cmpgt_epi8(a, b); }
+    inline block_t block_or(block_t a, block_t b) { return _mm256_or_si256(a, b); }
+    inline block_t block_and(block_t a, block_t b) { return _mm256_and_si256(a, b); }
+    inline uint32_t block_mask(block_t a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+#elif defined(__SSE2__)
+    #define ECHO_LEXER_SIMD 1
+    using block_t = __m128i;
+    constexpr size_t block_size = 16;
+    constexpr uint32_t block_full_mask = 0xFFFF;
+
+    inline block_t block_load(const char *p) { return _mm_loadu_si128(reinterpret_cast<const block_t *>(p)); }
+    inline block_t block_splat(char c) { return _mm_set1_epi8(c); }
+    inline block_t block_eq(block_t a, block_t b) { return _mm_cmpeq_epi8(a, b); }
+    inline block_t block_gt(block_t a, block_t b) { return _mm_cmpgt_epi8(a, b); }
+    inline block_t block_or(block_t a, block_t b) { return _mm_or_si128(a, b); }
+    inline block_t block_and(block_t a, block_t b) { return _mm_and_si128(a, b); }
+    inline uint32_t block_mask(block_t a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+#else
+    #define ECHO_LEXER_SIMD 0
+#endif
+
+#if ECHO_LEXER_SIMD
+    // mask of all bytes in the inclusive range [lo, hi], the compare is signed
+    // so this only works for ascii ranges, which is all we need (bytes >= 0x80 never match)
+    inline block_t block_in_range(block_t v, char lo, char hi) {
+        return block_and(block_gt(v, block_splat(lo - 1)), block_gt(block_splat(hi + 1), v));
+    }
+
+    inline uint32_t block_formatting_mask(block_t v) {
+        return block_mask(block_or(
+            block_or(block_eq(v, block_splat(' ')), block_eq(v, block_splat('\t'))),
+            block_eq(v, block_splat('\n'))
+        ));
+    }
+
+    inline uint32_t block_varname_mask(block_t v) {
+        // setting bit 0x20 maps upper case to lower case, digits and '_' are checked on the raw value
+        auto lower = block_or(v, block_splat(0x20));
+        return block_mask(block_or(
+            block_or(block_in_range(lower, 'a', 'z'), block_in_range(v, '0', '9')),
+            block_eq(v, block_splat('_'))
+        ));
+    }
+#endif
+
+    // returns the first byte that is not a formatting character (space, tab, newline)
+    inline const char *skip_formatting(const char *p, const char *end)
+    {
+#if ECHO_LEXER_SIMD
+        while (static_cast<size_t>(end - p) >= block_size) {
+            uint32_t mask = ~block_formatting_mask(block_load(p)) & block_full_mask;
+            if (mask) {
+                return p + std::countr_zero(mask);
+            }
+            p += block_size;
+        }
+#endif
+        while (p < end && is_formatting_char(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    // returns the first byte that cannot be part of a variable name / identifier
+    inline const char *skip_varname(const char *p, const char *end)
+    {
+#if ECHO_LEXER_SIMD
+        while (static_cast<size_t>(end - p) >= block_size) {
+            uint32_t mask = ~block_varname_mask(block_load(p)) & block_full_mask;
+            if (mask) {
+                return p + std::countr_zero(mask);
+            }
+            p += block_size;
+        }
+#endif
+        while (p < end && is_varname_char(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    // returns the first occurence of `a` or `b`
+    inline const char *find_any_of(const char *p, const char *end, char a, char b)
+    {
+#if ECHO_LEXER_SIMD
+        const auto va = block_splat(a);
+        const auto vb = block_splat(b);
+        while (static_cast<size_t>(end - p) >= block_size) {
+            auto v = block_load(p);
+            uint32_t mask = block_mask(block_or(block_eq(v, va), block_eq(v, vb)));
+            if (mask) {
+                return p + std::countr_zero(mask);
+            }
+            p += block_size;
+        }
+#endif
+        while (p < end && *p != a && *p != b) {
+            p++;
+        }
+        return p;
+    }
+
+    inline const char *find_char(const char *p, const char *end, char c) {
+        return find_any_of(p, end, c, c);
+    }
+
+    // counts the newlines in the given range, `last_newline` is set to the
+    // last newline found or left untouched if there is none
+    inline size_t count_newlines(const char *p, const char *end, const char *&last_newline)
+    {
+        size_t count = 0;
+#if ECHO_LEXER_SIMD
+        const auto vnl = block_splat('\n');
+        while (static_cast<size_t>(end - p) >= block_size) {
+            uint32_t mask = block_mask(block_eq(block_load(p), vnl));
+            if (mask) {
+                count += std::popcount(mask);
+                last_newline = p + (31 - std::countl_zero(mask));
+            }
+            p += block_size;
+        }
+#endif
+        while (p < end) {
+            if (*p == '\n') {
+                count++;
+                last_newline = p;
+            }
+            p++;
+        }
+        return count;
+    }
+}
+
+#endif
@@ -9,6 +9,8 @@
 #include "../Lexer.h"
 #include "../AST/ASTModule.h"
 #include "../AST/ASTCollector.h"
+#include "../AST/ASTBundle.h"
+#include "../ThreadPool.h"
 
 #include <memory>
 
@@ -19,6 +21,19 @@ namespace Parser
         std::unique_ptr<Lexer> _lexer;
 
     public:
+        struct FileEntry {
+            AST::module_handle_t module;
+            std::filesystem::path path;
+        };
+
+        // fold constant expressions and prune constant if blocks after a file is parsed
+        bool fold_constants = true;
+
+        // also lower every parsed file into its compact tree, which is only read by
+        // `LLVMCompiler::compile_bundle_compact` and required by it. It is built next to the
+        // node tree, `Module::release_nodes` frees the nodes once they are no longer needed
+        bool lower_compact = false;
+
         ModuleParser();
         ~ModuleParser() {};
         
@@ -26,12 +41,26 @@ namespace Parser
 
         Parser::Payload make_parser_payload(const AST::TokenizedFile &file, AST::Module &module, AST::Collector &collector) const;
 
+        Parser::Payload make_parser_payload(const AST::TokenizedFile &file, AST::Module &module, AST::NodeCollection &nodes, AST::Collector &collector) const;
+
         void parse_file_from_disk(
             std::filesystem::path path, 
             AST::Module &module, 
             AST::Collector &collector
         ) const;
 
+        /**
+         * Reads, tokenizes and parses the given files on the thread pool.
+         * Every file is lexed and parsed into its own token and node storage which is 
+         * merged into its module afterwards, the same goes for the collected issues which 
+         * end up in the bundles collector in the order the files have been passed.
+         */
+        void parse_files_from_disk(
+            const std::vector<FileEntry> &entries,
+            AST::Bundle &bundle,
+            ThreadPool &pool
+        ) const;
+
         void parse_file_from_mem(
             std::filesystem::path path,
             const std::string &content,
@@ -40,6 +69,8 @@ namespace Parser
         ) const;
 
     private:
+        // runs the passes over a parsed file and lowers it into its compact tree if requested
+        void finish_file(AST::File &file, AST::NodeCollection &nodes) const;
     };
 };
 
@@ -0,0 +1,92 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <cstdint>
+
+typedef uint32_t symbol_t;
+
+// marks a token / node that has no symbol attached
+constexpr symbol_t no_symbol = UINT32_MAX;
+
+namespace Symbol
+{
+    // symbols that are always interned first, so their ids are known 
+    // at compile time and can be checked without any lookup
+    enum Builtin : symbol_t {
+        s_int,
+        s_int8,
+        s_int16,
+        s_int32,
+        s_int64,
+        s_uint,
+        s_uint8,
+        s_uint16,
+        s_uint32,
+        s_uint64,
+        s_float,
+        s_float32,
+        s_float64,
+        s_bool,
+        s_void,
+        builtin_count
+    };
+
+    constexpr std::array<std::string_view, builtin_count> builtin_names = {
+        "int", "int8", "int16", "int32", "int64",
+        "uint", "uint8", "uint16", "uint32", "uint64",
+        "float", "float32", "float64",
+        "bool", "void"
+    };
+};
+
+/**
+ * Interns identifiers and variable names into dense 32 bit ids, 
+ * so everything after the lexer can compare and look up names by integer
+ * 
+ * The table is shared between files that are lexed concurrently, so all access is locked.
+ * Prefer interning in batches, the lexer does this once per input.
+ */
+class SymbolTable
+{
+public:
+    SymbolTable();
+    ~SymbolTable() {}
+
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    // returns the id of the given name, the name is added if it does not exist yet
+    symbol_t intern(std::string_view name);
+
+    // interns all given names while holding the lock only once, 
+    // the symbol of names[i] is written to symbols[i]
+    void intern(const std::vector<std::string_view> &names, std::vector<symbol_t> &symbols);
+
+    // returns the id of the given name or `no_symbol` if it was never interned
+    symbol_t find(std::string_view name) const;
+
+    std::string_view name(symbol_t symbol) const;
+
+    size_t size() const;
+
+private:
+    symbol_t intern_unlocked(std::string_view name);
+
+    mutable std::shared_mutex _mutex;
+
+    // a deque so the views in the lookup map stay valid
+    std::deque<std::string> _names;
+    std::unordered_map<std::string_view, symbol_t> _lookup;
+};
+
+#endif
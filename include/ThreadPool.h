@@ -0,0 +1,68 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A simple work stealing thread pool
+ * 
+ * Every worker owns a task queue, tasks are distributed round robin on submit. A worker
+ * takes tasks from the back of its own queue and when that runs dry steals from the front 
+ * of the other queues, so uneven tasks (a huge file next to many small ones) still keep all workers busy.
+ */
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // a thread count of 0 uses the number of hardware threads
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(Task task);
+
+    // blocks until all submitted tasks have been executed
+    void wait();
+
+    inline size_t size() const {
+        return _threads.size();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _work_available;
+    std::condition_variable _work_done;
+
+    // tasks sitting in a queue / tasks not yet finished
+    std::atomic<size_t> _queued = 0;
+    std::atomic<size_t> _pending = 0;
+
+    std::atomic<size_t> _next_queue = 0;
+    bool _stop = false;
+
+    bool try_pop(size_t queue_index, Task &task);
+
+    void worker_loop(size_t queue_index);
+};
+
+#endif
@@ -4,11 +4,15 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <cassert>
 
 #include <cstdint>
 
+#include "SymbolTable.h"
+
 struct Token {
 public:
     enum class Type {
@@ -69,8 +73,17 @@ public:
     uint32_t line;
     uint32_t char_offset; // if you have a file source file thats 2GB, you're have other problems
 
-    Token(Type type, uint32_t line, uint32_t char_offset)
-        : type(type), line(line), char_offset(char_offset) {}
+    // the value of the token is not copied, we only store where in 
+    // which source (see TokenCollection::sources) it can be found
+    uint32_t source;
+    uint32_t offset;
+    uint32_t length;
+
+    // identifiers and variable names are interned by the lexer (see SymbolTable)
+    symbol_t symbol;
+
+    Token(Type type, uint32_t line, uint32_t char_offset, uint32_t source = 0, uint32_t offset = 0, uint32_t length = 0, symbol_t symbol = no_symbol)
+        : type(type), line(line), char_offset(char_offset), source(source), offset(offset), length(length), symbol(symbol) {}
 
     inline bool is_a(Type type) const {
         return this->type == type;
@@ -101,16 +114,66 @@ struct TokenSlice;
 struct TokenCollection {
 
     std::vector<Token> tokens;
-    std::vector<std::string> token_values;
 
+    // views into the buffers the token values live in, usually the contents of the 
+    // tokenized files. The caller has to make sure these outlive the collection.
+    std::vector<std::string_view> sources;
+
+    // buffers owned by the collection, for copied inputs and values that 
+    // do not exist in any source (synthesized tokens). Heap allocated so the views
+    // stay valid when the collection grows or is appended to another one.
+    std::vector<std::unique_ptr<std::string>> owned_sources;
+
+    // the symbol table identifiers are interned into, modules of 
+    // the same bundle share one so symbols can be compared across modules
+    std::shared_ptr<SymbolTable> symbols = std::make_shared<SymbolTable>();
+
+    TokenCollection() = default;
+    // collects tokens into an existing symbol table, e.g. the one of the module they end up in
+    explicit TokenCollection(std::shared_ptr<SymbolTable> symbols) : symbols(std::move(symbols)) {}
+    TokenCollection(TokenCollection &&) = default;
+    TokenCollection &operator=(TokenCollection &&) = default;
+
+    // the sources hold views into owned_sources, a copy would point into the wrong collection
+    TokenCollection(const TokenCollection &) = delete;
+    TokenCollection &operator=(const TokenCollection &) = delete;
+
+    // registers a source buffer without copying it and returns its id
+    inline uint32_t add_source(std::string_view source) {
+        sources.push_back(source);
+        return static_cast<uint32_t>(sources.size() - 1);
+    }
+
+    // registers a copy of the given buffer and returns its id
+    inline uint32_t add_owned_source(std::string source) {
+        owned_sources.push_back(std::make_unique<std::string>(std::move(source)));
+        return add_source(*owned_sources.back());
+    }
+
+    // pushes a token that references a range of an already registered source
+    inline void push(uint32_t source, size_t offset, size_t length, Token::Type type, size_t line, size_t char_offset, symbol_t symbol = no_symbol) {
+        assert(source < sources.size() && offset + length <= sources[source].size());
+        tokens.emplace_back(type, line, char_offset, source, offset, length, symbol);
+    }
+
+    // pushes a token with a value that is not part of any source, this allocates
+    // so it should only be used for synthesized tokens
     void push(const std::string &value, Token::Type type, size_t line, size_t char_offset) {
-        tokens.emplace_back(type, line, char_offset);
-        token_values.push_back(value);
+        push(add_owned_source(value), 0, value.size(), type, line, char_offset);
     }
 
     void clear() {
         tokens.clear();
-        token_values.clear();
+        sources.clear();
+        owned_sources.clear();
+    }
+
+    // moves all tokens and sources of the other collection to the end of this one,
+    // both collections have to share the same symbol table
+    void append(TokenCollection &&other);
+
+    inline std::string_view value(const Token &token) const {
+        return sources[token.source].substr(token.offset, token.length);
     }
 
     inline size_t size() const {
@@ -155,9 +218,14 @@ public:
         return index < tokens.tokens.size();
     }
 
-    inline const std::string &value() const {
+    inline std::string_view value() const {
+        assert(is_valid());
+        return tokens.value(tokens.tokens[index]);
+    }
+
+    inline symbol_t symbol() const {
         assert(is_valid());
-        return tokens.token_values[index];
+        return tokens.tokens[index].symbol;
     }
 
     inline const Token &token() const {
@@ -0,0 +1,140 @@
+#include "EchoRuntime.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define ECHO_OUTPUT_BUFFER_SIZE (64 * 1024)
+
+// room every formatting function can assume, the longest "%f" of a double is 317 characters
+#define ECHO_MAX_LINE 512
+
+// a thread only ever appends to its own buffer, so no locking is needed
+static _Thread_local struct {
+    size_t length;
+    char data[ECHO_OUTPUT_BUFFER_SIZE];
+} output;
+
+void echo_runtime_flush(void)
+{
+    if (output.length > 0) {
+        fwrite(output.data, 1, output.length, stdout);
+        output.length = 0;
+    }
+}
+
+// returns where the next line of at most ECHO_MAX_LINE characters goes
+static char *output_reserve(void)
+{
+    if (output.length + ECHO_MAX_LINE > sizeof(output.data)) {
+        echo_runtime_flush();
+    }
+
+    return output.data + output.length;
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// writes the digits backwards ending right before `end`, two at a time, returns the first one
+static char *format_u64(char *end, uint64_t value)
+{
+    while (value >= 100) {
+        const char *pair = digit_pairs + (value % 100) * 2;
+        value /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+
+    if (value >= 10) {
+        const char *pair = digit_pairs + value * 2;
+        *--end = pair[1];
+        *--end = pair[0];
+    } else {
+        *--end = (char)('0' + value);
+    }
+
+    return end;
+}
+
+// appends the digits of the magnitude as a line, with a leading "-" if negative
+static void output_integer(uint64_t magnitude, int is_negative)
+{
+    char digits[24];
+    char *end = digits + sizeof(digits);
+
+    char *start = format_u64(end, magnitude);
+    if (is_negative) {
+        *--start = '-';
+    }
+
+    char *line = output_reserve();
+    size_t length = (size_t)(end - start);
+    memcpy(line, start, length);
+    line[length] = '\n';
+    output.length += length + 1;
+}
+
+void echo_i64(int64_t value)
+{
+    // negating in unsigned also works for the smallest value
+    output_integer(value < 0 ? 0 - (uint64_t)value : (uint64_t)value, value < 0);
+}
+
+void echo_i32(int32_t value)
+{
+    echo_i64(value);
+}
+
+void echo_u64(uint64_t value)
+{
+    output_integer(value, 0);
+}
+
+void echo_u32(uint32_t value)
+{
+    echo_u64(value);
+}
+
+void echo_f64(double value)
+{
+    char *line = output_reserve();
+    output.length += (size_t)snprintf(line, ECHO_MAX_LINE, "%f\n", value);
+}
+
+void echo_str(const char *value)
+{
+    size_t length = strlen(value);
+
+    // longer strings go out directly after everything before them
+    if (length >= ECHO_MAX_LINE) {
+        echo_runtime_flush();
+        fwrite(value, 1, length, stdout);
+        fputc('\n', stdout);
+        return;
+    }
+
+    char *line = output_reserve();
+    memcpy(line, value, length);
+    line[length] = '\n';
+    output.length += length + 1;
+}
+
+int echo_runtime_exit(void)
+{
+    echo_runtime_flush();
+
+    // in the JIT the process keeps running after main, the output
+    // of the program has to be out before the compiler prints anything else
+    fflush(stdout);
+
+    return 0;
+}
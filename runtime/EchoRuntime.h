@@ -0,0 +1,40 @@
+#ifndef ECHORUNTIME_H
+#define ECHORUNTIME_H
+
+/**
+ * The runtime compiled Echo programs are linked against
+ *
+ * Executables link the `echo_runtime` archive, code running in the JIT resolves the
+ * same functions from the compiler binary itself. The generated `main` returns
+ * the result of `echo_runtime_exit`.
+ *
+ * `echo` calls the function for the type of every argument, they format the value followed
+ * by a newline into an output buffer of the calling thread, which is written to stdout in
+ * large chunks whenever it fills up and when the program exits.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void echo_i32(int32_t value);
+void echo_i64(int64_t value);
+void echo_u32(uint32_t value);
+void echo_u64(uint64_t value);
+// formatted like "%f"
+void echo_f64(double value);
+void echo_str(const char *value);
+
+// writes the pending output of the calling thread to stdout
+void echo_runtime_flush(void);
+
+// flushes all pending output, returns the exit code of the program
+int echo_runtime_exit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,6 +11,15 @@ AST::Collector::~Collector()
 {
 }
 
+void AST::Collector::merge(Collector &&other)
+{
+    for (auto &issue : other.issues) {
+        issues.push_back(std::move(issue));
+    }
+
+    other.issues.clear();
+}
+
 void AST::Collector::print_issues() const
 {
     for (const auto &issue : issues)
@@ -0,0 +1,311 @@
+#include "AST/ASTCompact.h"
+
+#include "AST/ASTStaticVisitor.h"
+
+#include <unordered_map>
+
+AST::ValueTypePrimitive AST::CompactTree::result_type(cnode_t expr) const
+{
+    auto index = cnode_index(expr);
+
+    switch (cnode_kind(expr)) {
+        case CompactKind::c_literal_int:
+            return int_literals.type[index];
+        case CompactKind::c_literal_float:
+            return float_literals.type[index];
+        case CompactKind::c_literal_bool:
+            return ValueTypePrimitive::t_bool;
+        case CompactKind::c_varref:
+            return vardecls.type[varrefs.decl[index]];
+        case CompactKind::c_call:
+            return calls.type[index];
+        case CompactKind::c_binary:
+            return binaries.type[index];
+        case CompactKind::c_unary:
+            return result_type(unaries.expr[index]);
+        case CompactKind::c_cast:
+            return casts.type[index];
+        default:
+            return ValueTypePrimitive::t_void;
+    }
+}
+
+size_t AST::CompactTree::node_count() const
+{
+    return scopes.children.size()
+        + vardecls.symbol.size()
+        + int_literals.value.size()
+        + float_literals.value.size()
+        + bool_literals.value.size()
+        + varrefs.decl.size()
+        + calls.callee.size()
+        + binaries.op.size()
+        + unaries.op.size()
+        + casts.expr.size()
+        + functions.name.size()
+        + returns.expr.size()
+        + ifs.blocks.size();
+}
+
+namespace
+{
+    template <typename T>
+    size_t vector_bytes(const std::vector<T> &vec) {
+        return vec.capacity() * sizeof(T);
+    }
+
+    template <typename... Ts>
+    size_t vectors_bytes(const std::vector<Ts> &...vecs) {
+        return (vector_bytes(vecs) + ...);
+    }
+}
+
+size_t AST::CompactTree::memory_usage() const
+{
+    return vectors_bytes(
+        children,
+        scopes.children,
+        vardecls.symbol, vardecls.type, vardecls.init,
+        int_literals.type, int_literals.value,
+        float_literals.type, float_literals.value,
+        bool_literals.value,
+        varrefs.decl,
+        calls.callee, calls.callee_type, calls.args, calls.type,
+        binaries.op, binaries.lhs, binaries.rhs, binaries.type,
+        unaries.op, unaries.expr,
+        casts.type, casts.expr,
+        functions.name, functions.return_type, functions.args, functions.body,
+        returns.expr,
+        ifs.blocks
+    );
+}
+
+namespace
+{
+    using namespace AST;
+
+    // walks the node tree and appends every node to the compact tree,
+    // the handle of the last visited node is left in `_result`
+    class CompactLowering final : public StaticVisitor<CompactLowering>
+    {
+        CompactTree &_tree;
+        cnode_t _result = cnode_none;
+
+        // vardecl nodes are referenced by varrefs, so we have to remember where they went
+        std::unordered_map<const VarDeclNode *, uint32_t> _vardecls;
+
+        template <typename T>
+        uint32_t next_index(const std::vector<T> &storage) {
+            return static_cast<uint32_t>(storage.size());
+        }
+
+        // child lists have to be contiguous, but lowering a child can append
+        // children of its own, so the handles are collected first and then copied in one go
+        CompactRange push_children(const std::vector<cnode_t> &nodes) {
+            CompactRange range { static_cast<uint32_t>(_tree.children.size()), static_cast<uint32_t>(nodes.size()) };
+            _tree.children.insert(_tree.children.end(), nodes.begin(), nodes.end());
+            return range;
+        }
+
+    public:
+        CompactLowering(CompactTree &tree) : _tree(tree) {}
+        ~CompactLowering() {}
+
+        cnode_t lower(Node *node) {
+            if (node == nullptr) {
+                return cnode_none;
+            }
+
+            _result = cnode_none;
+            dispatch(*node);
+            return _result;
+        }
+
+        void visitScope(ScopeNode &node) override
+        {
+            std::vector<cnode_t> children;
+            children.reserve(node.children.size());
+
+            for (auto &child : node.children) {
+                auto lowered = lower(child.node());
+                if (lowered != cnode_none) {
+                    children.push_back(lowered);
+                }
+            }
+
+            auto index = next_index(_tree.scopes.children);
+            _tree.scopes.children.push_back(push_children(children));
+            _result = make_cnode(CompactKind::c_scope, index);
+        }
+
+        void visitVarDecl(VarDeclNode &node) override
+        {
+            // lower the initializer first, it cannot reference the variable itself
+            auto init = lower(node.init_expr);
+
+            auto index = next_index(_tree.vardecls.symbol);
+            _tree.vardecls.symbol.push_back(node.symbol);
+            // declarations that failed to parse have no type, the collector already has an issue for them
+            _tree.vardecls.type.push_back(
+                node.has_type() ? node.type_node()->type.get_primitive_type() : ValueTypePrimitive::t_void
+            );
+            _tree.vardecls.init.push_back(init);
+            _vardecls[&node] = index;
+
+            _result = make_cnode(CompactKind::c_vardecl, index);
+        }
+
+        void visitLiteralFloatExpr(LiteralFloatExprNode &node) override
+        {
+            auto type = node.get_effective_primitive_type();
+            auto index = next_index(_tree.float_literals.value);
+            _tree.float_literals.type.push_back(type);
+            _tree.float_literals.value.push_back(
+                type == ValueTypePrimitive::t_float64 ? node.double_value() : static_cast<double>(node.float_value())
+            );
+
+            _result = make_cnode(CompactKind::c_literal_float, index);
+        }
+
+        void visitLiteralIntExpr(LiteralIntExprNode &node) override
+        {
+            auto index = next_index(_tree.int_literals.value);
+            _tree.int_literals.type.push_back(node.result_type().get_primitive_type());
+            _tree.int_literals.value.push_back(node.uint64_value());
+
+            _result = make_cnode(CompactKind::c_literal_int, index);
+        }
+
+        void visitLiteralBoolExpr(LiteralBoolExprNode &node) override
+        {
+            auto index = next_index(_tree.bool_literals.value);
+            _tree.bool_literals.value.push_back(node.bool_value());
+
+            _result = make_cnode(CompactKind::c_literal_bool, index);
+        }
+
+        void visitVarRefExpr(VarRefExprNode &node) override
+        {
+            auto decl = _vardecls.find(node.var_ref->decl);
+            assert(decl != _vardecls.end() && "variable referenced before its declaration was lowered");
+
+            auto index = next_index(_tree.varrefs.decl);
+            _tree.varrefs.decl.push_back(decl->second);
+
+            _result = make_cnode(CompactKind::c_varref, index);
+        }
+
+        void visitFunctionCallExpr(FunctionCallExprNode &node) override
+        {
+            std::vector<cnode_t> args;
+            args.reserve(node.arguments.size());
+            for (auto arg : node.arguments) {
+                args.push_back(lower(arg));
+            }
+
+            auto index = next_index(_tree.calls.callee);
+            _tree.calls.callee.push_back(node.token_function_name.symbol());
+            _tree.calls.callee_type.push_back(node.token_function_name.type());
+            _tree.calls.args.push_back(push_children(args));
+            _tree.calls.type.push_back(node.result_type().get_primitive_type());
+
+            _result = make_cnode(CompactKind::c_call, index);
+        }
+
+        void visitBinaryExpr(BinaryExprNode &node) override
+        {
+            auto lhs = lower(node.lhs);
+            auto rhs = lower(node.rhs);
+
+            auto index = next_index(_tree.binaries.op);
+            _tree.binaries.op.push_back(node.op_node->op->type);
+            _tree.binaries.lhs.push_back(lhs);
+            _tree.binaries.rhs.push_back(rhs);
+            _tree.binaries.type.push_back(node.result_type().get_primitive_type());
+
+            _result = make_cnode(CompactKind::c_binary, index);
+        }
+
+        void visitUnaryExpr(UnaryExprNode &node) override
+        {
+            auto expr = lower(node.expr);
+
+            auto index = next_index(_tree.unaries.op);
+            _tree.unaries.op.push_back(node.token_operator.type());
+            _tree.unaries.expr.push_back(expr);
+
+            _result = make_cnode(CompactKind::c_unary, index);
+        }
+
+        void visitTypeCast(TypeCastNode &node) override
+        {
+            auto expr = lower(node.expr);
+
+            auto index = next_index(_tree.casts.expr);
+            _tree.casts.type.push_back(node.cast_to.get_primitive_type());
+            _tree.casts.expr.push_back(expr);
+
+            _result = make_cnode(CompactKind::c_cast, index);
+        }
+
+        void visitFunctionDecl(FunctionDeclNode &node) override
+        {
+            // arguments are lowered before the body so it can reference them
+            std::vector<cnode_t> args;
+            args.reserve(node.args.size());
+            for (auto arg : node.args) {
+                args.push_back(lower(arg));
+            }
+
+            auto args_range = push_children(args);
+            auto body = lower(node.body);
+
+            auto index = next_index(_tree.functions.name);
+            _tree.functions.name.push_back(node.name_token.has_value() ? node.name_token->symbol() : no_symbol);
+            _tree.functions.return_type.push_back(
+                node.return_type ? node.return_type->type.get_primitive_type() : ValueTypePrimitive::t_void
+            );
+            _tree.functions.args.push_back(args_range);
+            _tree.functions.body.push_back(body);
+
+            _result = make_cnode(CompactKind::c_func_decl, index);
+        }
+
+        void visitReturn(ReturnNode &node) override
+        {
+            auto expr = lower(node.expr);
+
+            auto index = next_index(_tree.returns.expr);
+            _tree.returns.expr.push_back(expr);
+
+            _result = make_cnode(CompactKind::c_return, index);
+        }
+
+        void visitIfStatement(IfStatementNode &node) override
+        {
+            std::vector<cnode_t> blocks;
+            blocks.reserve(node.blocks.size() * 2);
+            for (auto &block : node.blocks) {
+                blocks.push_back(lower(block.condition));
+                blocks.push_back(lower(block.block));
+            }
+
+            auto index = next_index(_tree.ifs.blocks);
+            _tree.ifs.blocks.push_back(push_children(blocks));
+
+            _result = make_cnode(CompactKind::c_if, index);
+        }
+
+        // nodes that do not produce anything on their own
+        void visitType(TypeNode &node) override {}
+        void visitVarRef(VarRefNode &node) override {}
+        void visitNull(NullNode &node) override {}
+        void visitOperator(OperatorNode &node) override {}
+    };
+}
+
+void AST::lower_to_compact(ScopeNode &root, CompactTree &tree)
+{
+    CompactLowering lowering(tree);
+    tree.root = lowering.lower(&root);
+}
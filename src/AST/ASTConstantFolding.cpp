@@ -0,0 +1,416 @@
+#include "AST/ASTConstantFolding.h"
+
+#include "AST/ASTOps.h"
+#include "AST/ASTStaticVisitor.h"
+
+#include <cmath>
+#include <cstdio>
+#include <optional>
+
+namespace
+{
+    using namespace AST;
+
+    // wraps the value around to the given integer size, like the arithmetic of that type does
+    int128_t wrap_to_size(uint128_t value, IntegerSize size)
+    {
+        auto bits = size.size * 8;
+        value &= (uint128_t(1) << bits) - 1;
+
+        if (size.is_signed && ((value >> (bits - 1)) & 1)) {
+            return static_cast<int128_t>(value) - (int128_t(1) << bits);
+        }
+
+        return static_cast<int128_t>(value);
+    }
+
+    // the exponent must not be negative, every step wraps around like a multiplication would
+    int128_t wrapping_pow(int128_t base, int128_t exponent, IntegerSize size)
+    {
+        uint128_t result = 1;
+        uint128_t factor = static_cast<uint128_t>(base);
+
+        while (exponent > 0) {
+            if (exponent & 1) {
+                result *= factor;
+            }
+            factor *= factor;
+            exponent >>= 1;
+        }
+
+        return wrap_to_size(result, size);
+    }
+
+    std::string int_literal_string(int128_t value)
+    {
+        // the digits are taken from the negative value, so the smallest value does not overflow
+        bool is_negative = value < 0;
+        if (!is_negative) {
+            value = -value;
+        }
+
+        std::string literal;
+        do {
+            literal.insert(literal.begin(), static_cast<char>('0' - value % 10));
+            value /= 10;
+        } while (value != 0);
+
+        if (is_negative) {
+            literal.insert(literal.begin(), '-');
+        }
+
+        return literal;
+    }
+
+    // enough digits to decode to the exact same value again
+    std::string float_literal_string(double value, ValueTypePrimitive type)
+    {
+        char buffer[32];
+        if (type == ValueTypePrimitive::t_float32) {
+            std::snprintf(buffer, sizeof(buffer), "%.9gf", value);
+        } else {
+            std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        }
+
+        return buffer;
+    }
+
+    inline bool is_literal(const ExprNode *expr, NodeType type) {
+        return expr != nullptr && expr->type_tag() == type;
+    }
+
+    // folds bottom up, every expression is replaced by what the visit leaves in `_result`
+    class ConstantFolding final : public StaticVisitor<ConstantFolding>
+    {
+        NodeCollection &_nodes;
+        ExprNode *_result = nullptr;
+
+        ExprNode *fold(ExprNode *expr) {
+            if (expr == nullptr) {
+                return nullptr;
+            }
+
+            _result = expr;
+            dispatch(*expr);
+            return _result;
+        }
+
+        LiteralIntExprNode &make_int(TokenReference token, ValueTypePrimitive type, int128_t value) {
+            auto &literal = _nodes.emplace_back<LiteralIntExprNode>(token, type);
+            literal.set_literal_value(int_literal_string(value));
+            return literal;
+        }
+
+        LiteralFloatExprNode &make_float(TokenReference token, ValueTypePrimitive type, double value) {
+            auto &literal = _nodes.emplace_back<LiteralFloatExprNode>(token, type);
+            literal.set_literal_value(float_literal_string(value, type));
+            return literal;
+        }
+
+        LiteralBoolExprNode &make_bool(TokenReference token, bool value) {
+            auto &literal = _nodes.emplace_back<LiteralBoolExprNode>(token);
+            literal.set_literal_value(value ? "true" : "false");
+            return literal;
+        }
+
+        ExprNode *fold_int_binary(BinaryExprNode &node, Token::Type op, LiteralIntExprNode &lhs, LiteralIntExprNode &rhs)
+        {
+            if (!lhs.is_decoded || !rhs.is_decoded) {
+                return &node;
+            }
+
+            auto type = lhs.result_type().get_primitive_type();
+            auto size = get_integer_size(type);
+            auto token = lhs.token_literal;
+
+            // the operands as the runtime sees them, so comparing them respects the signedness
+            auto a = wrap_to_size(static_cast<uint128_t>(lhs.value), size);
+            auto b = wrap_to_size(static_cast<uint128_t>(rhs.value), size);
+
+            switch (op) {
+                case Token::Type::t_op_add:
+                    return &make_int(token, type, wrap_to_size(static_cast<uint128_t>(a) + static_cast<uint128_t>(b), size));
+                case Token::Type::t_op_sub:
+                    return &make_int(token, type, wrap_to_size(static_cast<uint128_t>(a) - static_cast<uint128_t>(b), size));
+                case Token::Type::t_op_mul:
+                    return &make_int(token, type, wrap_to_size(static_cast<uint128_t>(a) * static_cast<uint128_t>(b), size));
+                case Token::Type::t_op_div:
+                case Token::Type::t_op_mod:
+                    // dividing by zero or the smallest value by -1 is undefined, that is left to the runtime
+                    if (b == 0 || (size.is_signed && b == -1 && a == size.get_max_negative_value())) {
+                        return &node;
+                    }
+                    return &make_int(token, type, op == Token::Type::t_op_div ? a / b : a % b);
+                case Token::Type::t_op_pow:
+                    if (b < 0) {
+                        return &node;
+                    }
+                    return &make_int(token, type, wrapping_pow(a, b, size));
+                case Token::Type::t_logical_eq:
+                    return &make_bool(token, a == b);
+                case Token::Type::t_logical_neq:
+                    return &make_bool(token, a != b);
+                case Token::Type::t_close_angle:
+                    return &make_bool(token, a > b);
+                case Token::Type::t_open_angle:
+                    return &make_bool(token, a < b);
+                case Token::Type::t_logical_geq:
+                    return &make_bool(token, a >= b);
+                case Token::Type::t_logical_leq:
+                    return &make_bool(token, a <= b);
+                default:
+                    return &node;
+            }
+        }
+
+        // computed in the precision of the type, a float is not folded through a double
+        template <typename T>
+        ExprNode *fold_float_binary(BinaryExprNode &node, Token::Type op, TokenReference token, ValueTypePrimitive type, T a, T b)
+        {
+            switch (op) {
+                case Token::Type::t_op_add:
+                    return &make_float(token, type, static_cast<T>(a + b));
+                case Token::Type::t_op_sub:
+                    return &make_float(token, type, static_cast<T>(a - b));
+                case Token::Type::t_op_mul:
+                    return &make_float(token, type, static_cast<T>(a * b));
+                case Token::Type::t_op_div:
+                    return &make_float(token, type, static_cast<T>(a / b));
+                case Token::Type::t_op_mod:
+                    return &make_float(token, type, static_cast<T>(std::fmod(a, b)));
+                case Token::Type::t_op_pow:
+                    return &make_float(token, type, static_cast<T>(std::pow(a, b)));
+                case Token::Type::t_logical_eq:
+                    return &make_bool(token, a == b);
+                case Token::Type::t_logical_neq:
+                    return &make_bool(token, a != b);
+                case Token::Type::t_close_angle:
+                    return &make_bool(token, a > b);
+                case Token::Type::t_open_angle:
+                    return &make_bool(token, a < b);
+                case Token::Type::t_logical_geq:
+                    return &make_bool(token, a >= b);
+                case Token::Type::t_logical_leq:
+                    return &make_bool(token, a <= b);
+                default:
+                    return &node;
+            }
+        }
+
+        ExprNode *fold_binary(BinaryExprNode &node)
+        {
+            if (node.lhs == nullptr || node.rhs == nullptr || node.op_node->op == nullptr) {
+                return &node;
+            }
+
+            // operands of different types are converted at runtime, which is not done here
+            if (node.lhs->result_type() != node.rhs->result_type()) {
+                return &node;
+            }
+
+            auto op = node.op_node->op->type;
+
+            if (is_literal(node.lhs, NodeType::n_literal_int) && is_literal(node.rhs, NodeType::n_literal_int)) {
+                return fold_int_binary(node, op, static_cast<LiteralIntExprNode &>(*node.lhs), static_cast<LiteralIntExprNode &>(*node.rhs));
+            }
+
+            if (is_literal(node.lhs, NodeType::n_literal_float) && is_literal(node.rhs, NodeType::n_literal_float)) {
+                auto &lhs = static_cast<LiteralFloatExprNode &>(*node.lhs);
+                auto &rhs = static_cast<LiteralFloatExprNode &>(*node.rhs);
+                auto type = lhs.get_effective_primitive_type();
+
+                if (type == ValueTypePrimitive::t_float32) {
+                    return fold_float_binary(node, op, lhs.token_literal, type, lhs.float_value(), rhs.float_value());
+                }
+                return fold_float_binary(node, op, lhs.token_literal, type, lhs.double_value(), rhs.double_value());
+            }
+
+            return &node;
+        }
+
+        ExprNode *fold_unary(UnaryExprNode &node)
+        {
+            // increment and decrement need a variable, only the negation is left
+            if (node.is_postfix || node.token_operator.type() != Token::Type::t_op_sub) {
+                return &node;
+            }
+
+            if (is_literal(node.expr, NodeType::n_literal_int)) {
+                auto &literal = static_cast<LiteralIntExprNode &>(*node.expr);
+                if (!literal.is_decoded) {
+                    return &node;
+                }
+
+                auto type = literal.result_type().get_primitive_type();
+                auto value = wrap_to_size(uint128_t(0) - static_cast<uint128_t>(literal.value), get_integer_size(type));
+                return &make_int(node.token_operator, type, value);
+            }
+
+            if (is_literal(node.expr, NodeType::n_literal_float)) {
+                auto &literal = static_cast<LiteralFloatExprNode &>(*node.expr);
+                auto type = literal.get_effective_primitive_type();
+
+                if (type == ValueTypePrimitive::t_float32) {
+                    return &make_float(node.token_operator, type, -literal.float_value());
+                }
+                return &make_float(node.token_operator, type, -literal.double_value());
+            }
+
+            return &node;
+        }
+
+        // a const variable initialized with a literal is replaced by a copy of it at every use
+        ExprNode *propagate(VarRefExprNode &node)
+        {
+            auto decl = node.var_ref->decl;
+            if (!decl->has_type() || !decl->type_node()->is_const || decl->init_expr == nullptr) {
+                return &node;
+            }
+
+            auto init = decl->init_expr;
+            if (init->result_type() != decl->type_node()->type) {
+                return &node;
+            }
+
+            auto token = node.var_ref->token_varname;
+
+            switch (init->type_tag()) {
+                case NodeType::n_literal_int: {
+                    auto &literal = static_cast<LiteralIntExprNode &>(*init);
+                    auto &copy = _nodes.emplace_back<LiteralIntExprNode>(token, literal.result_type().get_primitive_type());
+                    copy.set_literal_value(literal.effective_token_literal_value());
+                    return &copy;
+                }
+                case NodeType::n_literal_float: {
+                    auto &literal = static_cast<LiteralFloatExprNode &>(*init);
+                    auto &copy = _nodes.emplace_back<LiteralFloatExprNode>(token, literal.get_effective_primitive_type());
+                    copy.set_literal_value(literal.effective_token_literal_value());
+                    return &copy;
+                }
+                case NodeType::n_literal_bool:
+                    return &make_bool(token, static_cast<LiteralBoolExprNode &>(*init).bool_value());
+                default:
+                    return &node;
+            }
+        }
+
+        std::optional<bool> constant_condition(const ExprNode *condition) {
+            if (is_literal(condition, NodeType::n_literal_bool)) {
+                return static_cast<const LiteralBoolExprNode *>(condition)->bool_value();
+            }
+            return std::nullopt;
+        }
+
+    public:
+        ConstantFolding(NodeCollection &nodes) : _nodes(nodes) {}
+        ~ConstantFolding() {}
+
+        void visitScope(ScopeNode &node) override
+        {
+            for (auto &child : node.children) {
+                if (child.has()) {
+                    dispatch(child);
+                }
+            }
+
+            // if statements that lost all of their blocks
+            std::erase_if(node.children, [](const NodeReference &child) {
+                return child.has_type<IfStatementNode>() && child.get<IfStatementNode>().blocks.empty();
+            });
+        }
+
+        void visitVarDecl(VarDeclNode &node) override
+        {
+            node.init_expr = fold(node.init_expr);
+        }
+
+        void visitFunctionDecl(FunctionDeclNode &node) override
+        {
+            if (node.body != nullptr) {
+                dispatch(*node.body);
+            }
+        }
+
+        void visitReturn(ReturnNode &node) override
+        {
+            node.expr = fold(node.expr);
+        }
+
+        void visitIfStatement(IfStatementNode &node) override
+        {
+            std::vector<IfStatementNode::Block> blocks;
+            blocks.reserve(node.blocks.size());
+
+            for (auto &block : node.blocks) {
+                block.condition = fold(block.condition);
+                auto constant = constant_condition(block.condition);
+
+                // never entered
+                if (constant == false) {
+                    continue;
+                }
+
+                dispatch(*block.block);
+
+                // always entered once the blocks before did not match, so none after it ever is
+                if (constant == true) {
+                    blocks.emplace_back(nullptr, block.block);
+                    break;
+                }
+
+                blocks.push_back(block);
+            }
+
+            node.blocks = std::move(blocks);
+        }
+
+        void visitTypeCast(TypeCastNode &node) override
+        {
+            node.expr = fold(node.expr);
+            _result = &node;
+        }
+
+        void visitFunctionCallExpr(FunctionCallExprNode &node) override
+        {
+            for (auto &arg : node.arguments) {
+                arg = fold(arg);
+            }
+            _result = &node;
+        }
+
+        void visitBinaryExpr(BinaryExprNode &node) override
+        {
+            node.lhs = fold(node.lhs);
+            node.rhs = fold(node.rhs);
+            _result = fold_binary(node);
+        }
+
+        void visitUnaryExpr(UnaryExprNode &node) override
+        {
+            node.expr = fold(node.expr);
+            _result = fold_unary(node);
+        }
+
+        void visitVarRefExpr(VarRefExprNode &node) override
+        {
+            _result = propagate(node);
+        }
+
+        // literals are as folded as they get
+        void visitLiteralFloatExpr(LiteralFloatExprNode &node) override {}
+        void visitLiteralIntExpr(LiteralIntExprNode &node) override {}
+        void visitLiteralBoolExpr(LiteralBoolExprNode &node) override {}
+
+        // nodes without expressions below them
+        void visitType(TypeNode &node) override {}
+        void visitVarRef(VarRefNode &node) override {}
+        void visitNull(NullNode &node) override {}
+        void visitOperator(OperatorNode &node) override {}
+    };
+}
+
+void AST::fold_constants(Node &root, NodeCollection &nodes)
+{
+    ConstantFolding folding(nodes);
+    folding.dispatch(root);
+}
@@ -2,39 +2,107 @@
 
 #include <iostream>
 #include <fstream>
-#include <sstream>
 
-void AST::File::set_content(const std::string &content)
+#if defined(__unix__) || defined(__APPLE__)
+#define ECHO_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define ECHO_HAS_MMAP 0
+#endif
+
+AST::File::~File()
+{
+    release_content();
+}
+
+void AST::File::release_content()
+{
+#if ECHO_HAS_MMAP
+    if (_mapping) {
+        munmap(_mapping, _mapping_size);
+    }
+#endif
+
+    _mapping = nullptr;
+    _mapping_size = 0;
+    _owned_content.clear();
+    _content = {};
+    _has_content = false;
+}
+
+void AST::File::update_content_view(std::string_view content)
 {
-    this->content = content;
+    _content = content;
+    _has_content = true;
+
     _line_offsets.clear();
     _line_offsets.push_back(0);
-    for (size_t i = 0; i < content.size(); i++) {
-        if (content[i] == '\n') {
-            _line_offsets.push_back(i + 1);
-        }
+    for (auto i = _content.find('\n'); i != std::string_view::npos; i = _content.find('\n', i + 1)) {
+        _line_offsets.push_back(i + 1);
+    }
+}
+
+void AST::File::set_content(std::string content)
+{
+    release_content();
+
+    _owned_content = std::move(content);
+    update_content_view(_owned_content);
+}
+
+// if the first line is just "<?php" or "<?eco" we skip it
+// this is a TEMPORARY hack so my dump text editor will do syntax highlighting
+// without having to create a syntax highlighting extension..
+std::string_view strip_editor_header(std::string_view content)
+{
+    if (content.substr(0, 5) == "<?php" || content.substr(0, 5) == "<?eco") {
+        content.remove_prefix(5);
     }
+
+    return content;
 }
 
 void AST::File::read_from_disk() 
 {
-    // load the file into a string
-    // we probably should use a stream in the future
-    auto istrm = std::ifstream(_path);
-    auto stream = std::stringstream();
-
-    // if the first line is just "<?php" or "<?eco" we skip it
-    // this is a TEMPORARY hack so my dump text editor will do syntax highlighting
-    // without having to create a syntax highlighting extension..
-    stream << istrm.rdbuf();
-    auto str = stream.str();
-    if (str.substr(0, 5) == "<?php" || str.substr(0, 5) == "<?eco") {
-        stream.str(str.substr(5));
+    release_content();
+
+#if ECHO_HAS_MMAP
+    // map the file read only, the pages are shared with the page cache
+    // so we never hold a copy of the source in memory
+    int fd = open(_path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            auto size = static_cast<size_t>(st.st_size);
+            void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapping != MAP_FAILED) {
+                close(fd);
+
+                _mapping = mapping;
+                _mapping_size = size;
+                update_content_view(strip_editor_header(std::string_view(static_cast<const char *>(mapping), size)));
+                return;
+            }
+        }
+
+        close(fd);
     }
-    // end of hack
+#endif
 
-    // update the content
-    set_content(stream.str());
+    // fallback, read the entire file into a single owned buffer
+    auto istrm = std::ifstream(_path, std::ios::binary | std::ios::ate);
+    if (istrm) {
+        auto size = static_cast<size_t>(istrm.tellg());
+        istrm.seekg(0);
+        _owned_content.resize(size);
+        istrm.read(_owned_content.data(), size);
+    }
+
+    update_content_view(strip_editor_header(_owned_content));
 }
 
 std::string AST::File::debug_description() const
@@ -42,9 +110,9 @@ std::string AST::File::debug_description() const
     return root->node_description();
 }
 
-std::string AST::File::get_content_of_line(uint32_t line) const
+std::string_view AST::File::get_content_of_line(uint32_t line) const
 {
-    if (!content.has_value()) {
+    if (!_has_content) {
         return "";
     }
 
@@ -61,10 +129,10 @@ std::string AST::File::get_content_of_line(uint32_t line) const
     }
 
     size_t start = _line_offsets[line];
-    size_t end = content.value().size();
+    size_t end = _content.size();
     if (line + 1 < _line_offsets.size()) {
         end = _line_offsets[line + 1] - 1;
     }
 
-    return content.value().substr(start, end - start);
-}
\ No newline at end of file
+    return _content.substr(start, end - start);
+}
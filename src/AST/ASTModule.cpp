@@ -15,20 +15,36 @@ std::string AST::Module::debug_description() const
 
 AST::File &AST::Module::add_file(const std::filesystem::path &path)
 {
+    return add_file(std::make_unique<File>(path));
+}
+
+AST::File &AST::Module::add_file(std::unique_ptr<File> file)
+{
+    assert(file->module == nullptr && "File is already part of a module");
+
     auto file_index = _files.size();
-    _files.push_back(std::make_unique<File>(path));
+    _files.push_back(std::move(file));
+
+    auto &added = *_files[file_index].get();
 
-    auto &file = *_files[file_index].get();
+    added.module = this;
 
-    file.module = this;
+    return added;
+}
+
+void AST::Module::release_nodes()
+{
+    for (auto &file : _files) {
+        file->root = nullptr;
+    }
 
-    return file;
+    nodes.release();
 }
 
 AST::TokenizedFile & AST::Module::tokenize(Lexer &lexer, const AST::File &file)
 {
     // throw an error if the file content is not available
-    if (!file.content.has_value()) {
+    if (!file.has_content()) {
         throw std::runtime_error("Cannot tokenize a file without content");
     }
 
@@ -38,24 +54,41 @@ AST::TokenizedFile & AST::Module::tokenize(Lexer &lexer, const AST::File &file)
     }
 
     AST::OperatorRegistry ops;
-    lexer.tokenize_prepass_operators(file.content.value(), ops);
+    lexer.tokenize_prepass_operators(file.content(), ops);
+
+    size_t startindex = tokens.size();
+    lexer.tokenize_view(tokens, file.content(), &ops);
+    size_t endindex = tokens.size();
+
+    _tokenized_files.push_back(std::make_unique<TokenizedFile>(TokenizedFile {
+        .file = &file,
+        .token_slice = tokens.slice(startindex, endindex)
+    }));
+
+    return *_tokenized_files.back();
+}
+
+AST::TokenizedFile &AST::Module::add_tokenized_file(const AST::File &file, TokenCollection &&file_tokens)
+{
+    assert(file.module == this && "Cannot add tokens of a file that is not in this module");
 
     size_t startindex = tokens.size();
-    lexer.tokenize(tokens, file.content.value(), &ops);
+    tokens.append(std::move(file_tokens));
     size_t endindex = tokens.size();
 
-    _tokenized_files.push_back(TokenizedFile {
+    _tokenized_files.push_back(std::make_unique<TokenizedFile>(TokenizedFile {
         .file = &file,
         .token_slice = tokens.slice(startindex, endindex)
-    });
+    }));
 
-    return _tokenized_files.back();
+    return *_tokenized_files.back();
 }
 
 AST::module_handle_t AST::ModuleCollection::add_module(const std::string &name)
 {
     auto handle = _modules.size();
     _modules.push_back(std::make_unique<Module>(name, handle));
+    _modules.back()->tokens.symbols = symbols;
     _module_map[name] = handle;
     return handle;
 }
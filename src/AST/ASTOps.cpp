@@ -205,8 +205,14 @@ const AST::Operator *AST::OperatorRegistry::get_operator(const TokenReference &t
         return _predefined_operator_map[static_cast<size_t>(token.type())];
     }
 
+    // the lexer marks custom operators, every other token is rejected
+    // here instead of copying its value for the lookup
+    if (token.type() != Token::Type::t_op_custom) {
+        return nullptr;
+    }
+
     // try to match the token value to a custom operator
-    auto custom_op = _operator_symbol_map.find(token.value());
+    auto custom_op = _operator_symbol_map.find(std::string(token.value()));
     if (custom_op != _operator_symbol_map.end()) {
         return custom_op->second;
     }
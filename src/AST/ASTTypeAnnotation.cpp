@@ -0,0 +1,101 @@
+#include "AST/ASTTypeAnnotation.h"
+
+#include "AST/ASTStaticVisitor.h"
+
+namespace
+{
+    using namespace AST;
+
+    // walks the tree in post order, once the children of an expression are annotated
+    // resolving its own type only looks at their stored types
+    class TypeAnnotation final : public StaticVisitor<TypeAnnotation>
+    {
+        void annotate(Node *node) {
+            if (node != nullptr) {
+                dispatch(*node);
+            }
+        }
+
+        void store(ExprNode &node) {
+            node.annotated_type = node.resolve_type();
+        }
+
+    public:
+        void visitScope(ScopeNode &node) override
+        {
+            for (auto &child : node.children) {
+                annotate(child.node());
+            }
+        }
+
+        void visitVarDecl(VarDeclNode &node) override
+        {
+            annotate(node.init_expr);
+        }
+
+        void visitFunctionDecl(FunctionDeclNode &node) override
+        {
+            for (auto arg : node.args) {
+                annotate(arg);
+            }
+            annotate(node.body);
+        }
+
+        void visitReturn(ReturnNode &node) override
+        {
+            annotate(node.expr);
+        }
+
+        void visitIfStatement(IfStatementNode &node) override
+        {
+            for (auto &block : node.blocks) {
+                annotate(block.condition);
+                annotate(block.block);
+            }
+        }
+
+        void visitTypeCast(TypeCastNode &node) override
+        {
+            annotate(node.expr);
+            store(node);
+        }
+
+        void visitFunctionCallExpr(FunctionCallExprNode &node) override
+        {
+            for (auto arg : node.arguments) {
+                annotate(arg);
+            }
+            store(node);
+        }
+
+        void visitBinaryExpr(BinaryExprNode &node) override
+        {
+            annotate(node.lhs);
+            annotate(node.rhs);
+            store(node);
+        }
+
+        void visitUnaryExpr(UnaryExprNode &node) override
+        {
+            annotate(node.expr);
+            store(node);
+        }
+
+        void visitLiteralFloatExpr(LiteralFloatExprNode &node) override { store(node); }
+        void visitLiteralIntExpr(LiteralIntExprNode &node) override { store(node); }
+        void visitLiteralBoolExpr(LiteralBoolExprNode &node) override { store(node); }
+        void visitVarRefExpr(VarRefExprNode &node) override { store(node); }
+
+        // nodes without expressions below them
+        void visitType(TypeNode &node) override {}
+        void visitVarRef(VarRefNode &node) override {}
+        void visitNull(NullNode &node) override {}
+        void visitOperator(OperatorNode &node) override {}
+    };
+}
+
+void AST::annotate_types(Node &root)
+{
+    TypeAnnotation annotation;
+    annotation.dispatch(root);
+}
@@ -72,7 +72,7 @@ bool AST::ValueType::will_fit_into(ValueType other) const
 
     // for floating types we can just check if the size is smaller
     if (is_floating_type() && other.is_floating_type()) {
-        return get_primitive_size(primitive) <= get_primitive_size(other.primitive);
+        return get_primitive_size(get_primitive_type()) <= get_primitive_size(other.get_primitive_type());
     }            
 
     // for integers we need to check if the size is smaller and if the sign is compatible
@@ -81,11 +81,11 @@ bool AST::ValueType::will_fit_into(ValueType other) const
             return false;
         }
 
-        return get_primitive_size(primitive) <= get_primitive_size(other.primitive);
+        return get_primitive_size(get_primitive_type()) <= get_primitive_size(other.get_primitive_type());
     }
 
     // bool will fit into all numeric types
-    else if (primitive == ValueTypePrimitive::t_bool) {
+    else if (get_primitive_type() == ValueTypePrimitive::t_bool) {
         return other.is_numeric_type();
     }
 
@@ -1,5 +1,8 @@
 #include "AST/ASTValueTypeCollection.h"
 
+#include <algorithm>
+#include <cassert>
+
 AST::ValueTypeCollection::ValueTypeCollection()
 {
 
@@ -9,8 +12,88 @@ AST::ValueTypeCollection::~ValueTypeCollection()
 {
 }
 
-AST::vt_handle_t AST::ValueTypeCollection::push_type(ValueType type)
+std::string AST::ValueTypeCollection::make_key(const ValueTypeDescriptor &descriptor)
+{
+    // every part is length prefixed, so names cannot run into each other
+    std::string key = std::to_string(static_cast<int>(descriptor.kind));
+
+    auto add = [&key](const std::string &part) {
+        key += ':';
+        key += std::to_string(part.size());
+        key += ':';
+        key += part;
+    };
+
+    add(descriptor.name.value_or(""));
+    for (auto &[name, type] : descriptor.properties) {
+        add(name);
+        key += ':';
+        key += std::to_string(type.get_handle());
+    }
+
+    return key;
+}
+
+AST::ValueType AST::ValueTypeCollection::intern(ValueTypeDescriptor descriptor)
 {
-    value_types.push_back(type);
-    return value_types.size() - 1;
-}
\ No newline at end of file
+    assert(descriptor.kind == ValueTypeKind::t_class || descriptor.kind == ValueTypeKind::t_struct);
+
+    std::sort(descriptor.properties.begin(), descriptor.properties.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    auto key = make_key(descriptor);
+
+    auto found = _handles.find(key);
+    if (found != _handles.end()) {
+        return ValueType::from_handle(found->second);
+    }
+
+    auto handle = ValueType::first_interned_handle + static_cast<vt_handle_t>(_descriptors.size());
+    _descriptors.push_back(std::move(descriptor));
+    _handles.emplace(std::move(key), handle);
+
+    return ValueType::from_handle(handle);
+}
+
+const AST::ValueTypeDescriptor &AST::ValueTypeCollection::descriptor(ValueType type) const
+{
+    assert(type.is_interned() && type.get_handle() - ValueType::first_interned_handle < _descriptors.size());
+    return _descriptors[type.get_handle() - ValueType::first_interned_handle];
+}
+
+AST::ValueTypeKind AST::ValueTypeCollection::kind(ValueType type) const
+{
+    if (type.is_primitive()) {
+        return ValueTypeKind::t_primitive;
+    }
+
+    if (type.is_unknown()) {
+        return ValueTypeKind::t_unknown;
+    }
+
+    return descriptor(type).kind;
+}
+
+std::string AST::ValueTypeCollection::get_type_description(ValueType type) const
+{
+    if (!type.is_interned()) {
+        return type.get_type_desciption();
+    }
+
+    auto &desc = descriptor(type);
+    if (desc.name.has_value()) {
+        return desc.name.value();
+    }
+
+    std::string signature = "{";
+    for (auto it = desc.properties.begin(); it != desc.properties.end(); ++it) {
+        signature += get_type_description(it->second);
+        if (std::next(it) != desc.properties.end()) {
+            signature += ", ";
+        }
+    }
+
+    signature += "}";
+    return signature;
+}
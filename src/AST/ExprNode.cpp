@@ -1,6 +1,6 @@
 #include "AST/ExprNode.h"
 
-AST::ValueType AST::BinaryExprNode::result_type() const
+AST::ValueType AST::BinaryExprNode::resolve_type() const
 {   
     if (lhs == nullptr || rhs == nullptr) {
         return AST::ValueType::make_void();
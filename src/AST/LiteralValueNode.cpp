@@ -1 +1,60 @@
 #include "AST/LiteralValueNode.h"
+
+#include <cstdlib>
+
+std::optional<AST::int128_t> AST::LiteralIntExprNode::decode_literal(std::string_view literal)
+{
+    bool is_negative = !literal.empty() && literal.front() == '-';
+    if (is_negative) {
+        literal.remove_prefix(1);
+    }
+
+    if (literal.empty()) {
+        return std::nullopt;
+    }
+
+    // accumulated negative, the negative range is one larger
+    int128_t value = 0;
+    for (char c : literal) {
+        if (c < '0' || c > '9') {
+            return std::nullopt;
+        }
+
+        if (__builtin_mul_overflow(value, 10, &value) || __builtin_sub_overflow(value, c - '0', &value)) {
+            return std::nullopt;
+        }
+    }
+
+    if (is_negative) {
+        return value;
+    }
+
+    if (__builtin_sub_overflow(int128_t(0), value, &value)) {
+        return std::nullopt;
+    }
+
+    return value;
+}
+
+void AST::LiteralIntExprNode::decode()
+{
+    auto decoded = decode_literal(override_literal_value ? std::string_view(*override_literal_value) : token_literal.value());
+
+    is_decoded = decoded.has_value();
+    value = decoded.value_or(0);
+}
+
+void AST::LiteralFloatExprNode::decode()
+{
+    auto literal = override_literal_value ? std::string_view(*override_literal_value) : token_literal.value();
+
+    double_precision = literal.empty() || literal.back() != 'f';
+    if (!double_precision) {
+        literal.remove_suffix(1);
+    }
+
+    // tokens point into the source, the conversion functions need a terminated copy
+    std::string digits(literal);
+    value_f64 = std::strtod(digits.c_str(), nullptr);
+    value_f32 = std::strtof(digits.c_str(), nullptr);
+}
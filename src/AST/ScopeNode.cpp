@@ -16,35 +16,22 @@ const std::string AST::ScopeNode::node_description()
 void AST::ScopeNode::add_vardecl(VarDeclNode &vardecl)
 {
     children.push_back(AST::make_ref(vardecl));
-    _declared_variables[vardecl.token_varname.value()] = &vardecl;
+    _declared_variables[vardecl.symbol] = &vardecl;
 }
 
-bool AST::ScopeNode::is_varname_taken(const std::string &varname) const
+bool AST::ScopeNode::is_symbol_taken(symbol_t symbol) const
 {
-    // first check if the variable is declared in the local scope
-    auto in_local_scope = _declared_variables.find(varname) != _declared_variables.end();
-    if (in_local_scope) {
-        return true;
-    }
-
-    // if this is not the root scope, check the parent tree
-    if (!is_root()) {
-        return parent().is_varname_taken(varname);
-    }
-    
-    return false;
+    return find_vardecl_by_symbol(symbol) != nullptr;
 }
 
-AST::VarDeclNode *AST::ScopeNode::find_vardecl_by_name(const std::string &varname) const
+AST::VarDeclNode *AST::ScopeNode::find_vardecl_by_symbol(symbol_t symbol) const
 {
-    auto found = _declared_variables.find(varname);
-    if (found != _declared_variables.end()) {
-        return found->second;
-    }
-
-    // if this is not the root scope, check the parent tree
-    if (!is_root()) {
-        return parent().find_vardecl_by_name(varname);
+    // walk up the scope tree, no recursion needed
+    for (auto scope = this; scope != nullptr; scope = scope->parent_ptr) {
+        auto found = scope->_declared_variables.find(symbol);
+        if (found != scope->_declared_variables.end()) {
+            return found->second;
+        }
     }
     
     return nullptr;
@@ -11,7 +11,7 @@ const std::string AST::VarDeclNode::node_description()
         typestr = "unknown";
     }
 
-    std::string desc = "vardecl<" + typestr + ">(" + token_varname.value() + ")";
+    std::string desc = "vardecl<" + typestr + ">(" + std::string(token_varname.value()) + ")";
 
     if (init_expr != nullptr) {
         desc += " = " + init_expr->node_description();
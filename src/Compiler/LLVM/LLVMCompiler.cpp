@@ -1,15 +1,19 @@
 #include "Compiler/LLVM/LLVMCompiler.h"
 
-#include <llvm/ExecutionEngine/ExecutionEngine.h>
-#include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/InitLLVM.h>
 #include <llvm/IR/Verifier.h>
-#include <llvm/ExecutionEngine/GenericValue.h>
 #include <llvm/Passes/PassBuilder.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/Transforms/Scalar.h>
 #include <llvm/Transforms/Scalar/GVN.h>
 #include <llvm/Transforms/Utils.h>
+#include <llvm/Transforms/Utils/Mem2Reg.h>
 
 #include "AST/VarDeclNode.h"
 #include "AST/LiteralValueNode.h"
@@ -19,58 +23,313 @@
 #include "AST/FunctionDeclNode.h"
 #include "AST/IfStatementNode.h"
 
+#include "EchoBuildId.h"
+
 #include <iostream>
+#include <mutex>
 
-LLVMCompiler::LLVMCompiler()
+LLVMCompiler::LLVMCompiler() :
+    build_id(ECHO_BUILD_ID)
 {
-
+    // target machines are created on worker threads, the registration has to happen before
+    static std::once_flag native_target_initialized;
+    std::call_once(native_target_initialized, []() {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+    });
 }
 
 LLVMCompiler::~LLVMCompiler()
 {
 }
 
-void LLVMCompiler::compile_bundle(const AST::Bundle &bundle)
+std::optional<LLVMCompiler::OptLevel> LLVMCompiler::parse_opt_level(std::string_view flag)
+{
+    if (flag == "-O0") return OptLevel::O0;
+    if (flag == "-O1") return OptLevel::O1;
+    if (flag == "-O2") return OptLevel::O2;
+    if (flag == "-O3") return OptLevel::O3;
+    if (flag == "-Os") return OptLevel::Os;
+    return std::nullopt;
+}
+
+static llvm::OptimizationLevel pipeline_level(LLVMCompiler::OptLevel level)
+{
+    switch (level) {
+        case LLVMCompiler::OptLevel::O1: return llvm::OptimizationLevel::O1;
+        case LLVMCompiler::OptLevel::O2: return llvm::OptimizationLevel::O2;
+        case LLVMCompiler::OptLevel::O3: return llvm::OptimizationLevel::O3;
+        case LLVMCompiler::OptLevel::Os: return llvm::OptimizationLevel::Os;
+        default: return llvm::OptimizationLevel::O0;
+    }
+}
+
+// size optimized code still gets the default instruction selection
+static llvm::CodeGenOptLevel codegen_level(LLVMCompiler::OptLevel level)
+{
+    switch (level) {
+        case LLVMCompiler::OptLevel::O1: return llvm::CodeGenOptLevel::Less;
+        case LLVMCompiler::OptLevel::O2: return llvm::CodeGenOptLevel::Default;
+        case LLVMCompiler::OptLevel::O3: return llvm::CodeGenOptLevel::Aggressive;
+        case LLVMCompiler::OptLevel::Os: return llvm::CodeGenOptLevel::Default;
+        default: return llvm::CodeGenOptLevel::None;
+    }
+}
+
+static constexpr std::string_view llvm_version = "llvm " LLVM_VERSION_STRING;
+
+std::string LLVMCompiler::object_cache_key(const AST::Bundle &bundle, std::string_view mode) const
+{
+    llvm::SHA256 hash;
+
+    // every part is length prefixed, so moving bytes from one to the next changes the key
+    auto add = [&hash](std::string_view part) {
+        auto size = std::to_string(part.size()) + ":";
+        hash.update(llvm::StringRef(size));
+        hash.update(llvm::StringRef(part.data(), part.size()));
+    };
+
+    auto target = make_target_builder(opt_level);
+
+    add(build_id);
+    add(llvm_version);
+    add(mode);
+    add(std::to_string(static_cast<int>(opt_level)));
+    add(target.getTargetTriple().str());
+    add(target.getCPU());
+    add(target.getFeatures().getString());
+
+    // the profile is part of the input, the instrumented code embeds the path of its output
+    add(profile_generate);
+    add(profile_use);
+    if (!profile_use.empty()) {
+        auto profile = llvm::MemoryBuffer::getFile(profile_use);
+        add(profile ? (*profile)->getBuffer() : llvm::StringRef());
+    }
+
+    for (auto &module : bundle.modules) {
+        add(module->name);
+        for (auto &file : module->files()) {
+            add(file.content());
+        }
+    }
+
+    return llvm::toHex(hash.final(), true);
+}
+
+bool LLVMCompiler::load_cached_objects(const AST::Bundle &bundle, std::string_view mode)
+{
+    units.clear();
+    objects.clear();
+    pending_cache_key.clear();
+
+    if (!object_cache) {
+        return false;
+    }
+
+    auto key = object_cache_key(bundle, mode);
+    objects = object_cache->load(key);
+    if (!objects.empty()) {
+        return true;
+    }
+
+    pending_cache_key = key;
+    return false;
+}
+
+void LLVMCompiler::begin_compile(const std::string &unit_name)
 {
     llvm_context = std::make_unique<llvm::LLVMContext>();
-    llvm_module = std::make_unique<llvm::Module>("echo_module", *llvm_context);
+    llvm_module = std::make_unique<llvm::Module>(unit_name, *llvm_context);
     llvm_builder = std::make_unique<llvm::IRBuilder<>>(*llvm_context);
+    function_map.clear();
+    var_map.clear();
 
     if (!llvm_module) {
         llvm::errs() << "Failed to create module.\n";
     }
 
-    llvm::FunctionCallee CalleeF = llvm_module->getOrInsertFunction("printf",
-        llvm::FunctionType::get(llvm::IntegerType::getInt32Ty(*llvm_context), llvm::PointerType::get(llvm::Type::getInt8Ty(*llvm_context), 0), true /* this is var arg func type*/) 
-    );
+    // the output functions of the runtime, see runtime/EchoRuntime.h
+    auto *void_type = llvm::Type::getVoidTy(*llvm_context);
+    llvm_module->getOrInsertFunction("echo_i32", void_type, llvm::Type::getInt32Ty(*llvm_context));
+    llvm_module->getOrInsertFunction("echo_i64", void_type, llvm::Type::getInt64Ty(*llvm_context));
+    llvm_module->getOrInsertFunction("echo_u32", void_type, llvm::Type::getInt32Ty(*llvm_context));
+    llvm_module->getOrInsertFunction("echo_u64", void_type, llvm::Type::getInt64Ty(*llvm_context));
+    llvm_module->getOrInsertFunction("echo_f64", void_type, llvm::Type::getDoubleTy(*llvm_context));
+    llvm_module->getOrInsertFunction("echo_str", void_type, llvm::PointerType::get(llvm::Type::getInt8Ty(*llvm_context), 0));
+}
+
+void LLVMCompiler::finish_unit()
+{
+    llvm_builder.reset();
+
+#ifndef NDEBUG
+    for (auto &function : *llvm_module) {
+        if (!function.isDeclaration() && llvm::verifyFunction(function, &llvm::errs())) {
+            llvm::errs() << "Invalid IR generated for function '" << function.getName() << "'\n";
+        }
+    }
+#endif
+
+    optimize_module(*llvm_module, opt_level);
+    units.push_back(CompiledUnit { std::move(llvm_context), std::move(llvm_module) });
+}
+
+void LLVMCompiler::compile_bundle(const AST::Bundle &bundle)
+{
+    if (load_cached_objects(bundle, "serial")) {
+        return;
+    }
+
+    begin_compile();
 
     // first fetch all function declarations
     for (auto &module : bundle.modules) {
         for (auto &file : module->files()) {
             for (auto &node : file.root->children) {
                 if (node.has_type<AST::FunctionDeclNode>()) {
-                    auto func_decl = node.get<AST::FunctionDeclNode>();
-                    func_decl.accept(*this);
+                    visitFunctionDecl(node.get<AST::FunctionDeclNode>());
                 }
             }
         }
     }
-    llvm::FunctionType *funcType = llvm::FunctionType::get(llvm_builder->getVoidTy(), false);
-    llvm::Function *function = llvm::Function::Create(funcType, llvm::Function::ExternalLinkage, "main", llvm_module.get());
-    llvm::BasicBlock *entry = llvm::BasicBlock::Create(*llvm_context, "entry", function);
-    llvm_builder->SetInsertPoint(entry);
+    begin_main_function();
 
     for (auto &module : bundle.modules) {
         for (auto &file : module->files()) {
-            file.root->accept(*this);
+            visitScope(*file.root);
         }
     }
 
-    // terminate the function
+    end_main_function();
+
+    finish_unit();
+}
+
+void LLVMCompiler::begin_main_function()
+{
+    // a regular C entry point, so the objects can be linked into an executable
+    llvm::Type *int_type = llvm_builder->getInt32Ty();
+    llvm::Type *argv_type = llvm::PointerType::get(llvm::PointerType::get(llvm_builder->getInt8Ty(), 0), 0);
+    llvm::FunctionType *main_type = llvm::FunctionType::get(int_type, { int_type, argv_type }, false);
+
+    llvm::Function *function = llvm::Function::Create(main_type, llvm::Function::ExternalLinkage, "main", llvm_module.get());
+    function->getArg(0)->setName("argc");
+    function->getArg(1)->setName("argv");
+
+    llvm_builder->SetInsertPoint(llvm::BasicBlock::Create(*llvm_context, "entry", function));
+}
+
+void LLVMCompiler::end_main_function()
+{
+    auto runtime_exit = llvm_module->getOrInsertFunction("echo_runtime_exit", llvm::FunctionType::get(llvm_builder->getInt32Ty(), false));
+    llvm_builder->CreateRet(llvm_builder->CreateCall(runtime_exit));
+}
+
+static std::string module_init_function_name(const AST::Module &module) {
+    return "echo_init_" + module.name;
+}
+
+void LLVMCompiler::compile_module_unit(const AST::Bundle &bundle, AST::Module &module)
+{
+    begin_compile("echo_module_" + module.name);
+
+    // functions of other modules are declared, the linker / JIT resolves them
+    for (auto &other : bundle.modules) {
+        for (auto &file : other->files()) {
+            for (auto &node : file.root->children) {
+                if (node.has_type<AST::FunctionDeclNode>()) {
+                    declare_function(node.get<AST::FunctionDeclNode>());
+                }
+            }
+        }
+    }
+
+    for (auto &file : module.files()) {
+        for (auto &node : file.root->children) {
+            if (node.has_type<AST::FunctionDeclNode>()) {
+                visitFunctionDecl(node.get<AST::FunctionDeclNode>());
+            }
+        }
+    }
+
+    // the top level code of the module
+    llvm::FunctionType *init_type = llvm::FunctionType::get(llvm_builder->getVoidTy(), false);
+    llvm::Function *init = llvm::Function::Create(init_type, llvm::Function::ExternalLinkage, module_init_function_name(module), llvm_module.get());
+    llvm_builder->SetInsertPoint(llvm::BasicBlock::Create(*llvm_context, "entry", init));
+
+    for (auto &file : module.files()) {
+        visitScope(*file.root);
+    }
+
     llvm_builder->CreateRetVoid();
 
-    // optimize the module
-    // optimize();
+    finish_unit();
+}
+
+void LLVMCompiler::compile_bundle_parallel(const AST::Bundle &bundle, ThreadPool &pool)
+{
+    if (load_cached_objects(bundle, "parallel")) {
+        return;
+    }
+
+    // every module gets a compiler of its own, they share nothing but the (read only) AST
+    std::vector<std::unique_ptr<LLVMCompiler>> workers;
+    std::vector<std::exception_ptr> errors;
+
+    workers.reserve(bundle.modules.size());
+    for (size_t i = 0; i < bundle.modules.size(); i++) {
+        workers.push_back(std::make_unique<LLVMCompiler>());
+        workers.back()->opt_level = opt_level;
+        // every unit is optimized for the target in `finish_unit`, so the workers need the same one
+        workers.back()->target_cpu = target_cpu;
+        workers.back()->target_features = target_features;
+        workers.back()->profile_generate = profile_generate;
+        workers.back()->profile_use = profile_use;
+    }
+    errors.resize(workers.size());
+
+    size_t index = 0;
+    for (auto &module : bundle.modules) {
+        pool.submit([&bundle, &ast_module = *module, &worker = *workers[index], &error = errors[index]]() {
+            try {
+                worker.compile_module_unit(bundle, ast_module);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        });
+        index++;
+    }
+
+    // meanwhile build the entry point, calling the module init functions in bundle order
+    begin_compile("echo_main");
+
+    begin_main_function();
+
+    llvm::FunctionType *void_type = llvm::FunctionType::get(llvm_builder->getVoidTy(), false);
+    for (auto &module : bundle.modules) {
+        auto init = llvm_module->getOrInsertFunction(module_init_function_name(*module), void_type);
+        llvm_builder->CreateCall(init);
+    }
+
+    end_main_function();
+
+    pool.wait();
+
+    for (auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (auto &worker : workers) {
+        for (auto &unit : worker->units) {
+            units.push_back(std::move(unit));
+        }
+    }
+
+    finish_unit();
 }
 
 void LLVMCompiler::visitScope(AST::ScopeNode &node)
@@ -82,7 +341,7 @@ void LLVMCompiler::visitScope(AST::ScopeNode &node)
             continue;
         }
 
-        child.node()->accept(*this);
+        dispatch(child);
     }
 }
 
@@ -93,102 +352,102 @@ void LLVMCompiler::visitType(AST::TypeNode &node)
 void LLVMCompiler::visitTypeCast(AST::TypeCastNode &node)
 {
     // visit the expression
-    node.expr->accept(*this);
-
-    // create a new value with the new type
-    auto new_type = node.result_type().get_primitive_type();
-    auto old_type = node.expr->result_type().get_primitive_type();
-
-    auto new_llvm_type = get_llvm_type(new_type);
+    dispatch(*node.expr);
 
     auto value = value_stack.top();
     value_stack.pop();
 
+    value_stack.push(emit_cast(value, node.expr->result_type().get_primitive_type(), node.result_type().get_primitive_type()));
+}
+
+llvm::Value *LLVMCompiler::emit_cast(llvm::Value *value, AST::ValueTypePrimitive old_type, AST::ValueTypePrimitive new_type)
+{
+    auto new_llvm_type = get_llvm_type(new_type);
 
     // @TODO make this pretty, i just wanted to try this out quickly
 
     if (old_type == new_type) {
-        value_stack.push(value);
+        return value;
     } else if (old_type == AST::ValueTypePrimitive::t_float32 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateFPExt(value, new_llvm_type));
+        return llvm_builder->CreateFPExt(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_float64 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateFPTrunc(value, new_llvm_type));
+        return llvm_builder->CreateFPTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int8 && new_type == AST::ValueTypePrimitive::t_int16) {
-        value_stack.push(llvm_builder->CreateSExt(value, new_llvm_type));
+        return llvm_builder->CreateSExt(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int16 && new_type == AST::ValueTypePrimitive::t_int8) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int32 && new_type == AST::ValueTypePrimitive::t_int8) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int32 && new_type == AST::ValueTypePrimitive::t_int16) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int64 && new_type == AST::ValueTypePrimitive::t_int8) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int64 && new_type == AST::ValueTypePrimitive::t_int16) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int64 && new_type == AST::ValueTypePrimitive::t_int32) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint8 && new_type == AST::ValueTypePrimitive::t_uint16) {
-        value_stack.push(llvm_builder->CreateZExt(value, new_llvm_type));
+        return llvm_builder->CreateZExt(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint16 && new_type == AST::ValueTypePrimitive::t_uint8) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint32 && new_type == AST::ValueTypePrimitive::t_uint8) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint32 && new_type == AST::ValueTypePrimitive::t_uint16) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint64 && new_type == AST::ValueTypePrimitive::t_uint8) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint64 && new_type == AST::ValueTypePrimitive::t_uint16) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint64 && new_type == AST::ValueTypePrimitive::t_uint32) {
-        value_stack.push(llvm_builder->CreateTrunc(value, new_llvm_type));
+        return llvm_builder->CreateTrunc(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int8 && new_type == AST::ValueTypePrimitive::t_uint8) {
-        value_stack.push(llvm_builder->CreateIntCast(value, new_llvm_type, false));
+        return llvm_builder->CreateIntCast(value, new_llvm_type, false);
     } else if (old_type == AST::ValueTypePrimitive::t_int16 && new_type == AST::ValueTypePrimitive::t_uint16) {
-        value_stack.push(llvm_builder->CreateIntCast(value, new_llvm_type, false));
+        return llvm_builder->CreateIntCast(value, new_llvm_type, false);
     } else if (old_type == AST::ValueTypePrimitive::t_int32 && new_type == AST::ValueTypePrimitive::t_uint32) {
-        value_stack.push(llvm_builder->CreateIntCast(value, new_llvm_type, false));
+        return llvm_builder->CreateIntCast(value, new_llvm_type, false);
     } else if (old_type == AST::ValueTypePrimitive::t_int64 && new_type == AST::ValueTypePrimitive::t_uint64) {
-        value_stack.push(llvm_builder->CreateIntCast(value, new_llvm_type, false));
+        return llvm_builder->CreateIntCast(value, new_llvm_type, false);
     } else if (old_type == AST::ValueTypePrimitive::t_uint8 && new_type == AST::ValueTypePrimitive::t_int8) {
-        value_stack.push(llvm_builder->CreateIntCast(value, new_llvm_type, true));
+        return llvm_builder->CreateIntCast(value, new_llvm_type, true);
     } else if (old_type == AST::ValueTypePrimitive::t_uint16 && new_type == AST::ValueTypePrimitive::t_int16) {
-        value_stack.push(llvm_builder->CreateIntCast(value, new_llvm_type, true));
+        return llvm_builder->CreateIntCast(value, new_llvm_type, true);
     } else if (old_type == AST::ValueTypePrimitive::t_uint32 && new_type == AST::ValueTypePrimitive::t_int32) {
-        value_stack.push(llvm_builder->CreateIntCast(value, new_llvm_type, true));
+        return llvm_builder->CreateIntCast(value, new_llvm_type, true);
     } else if (old_type == AST::ValueTypePrimitive::t_uint64 && new_type == AST::ValueTypePrimitive::t_int64) {
-        value_stack.push(llvm_builder->CreateIntCast(value, new_llvm_type, true));
+        return llvm_builder->CreateIntCast(value, new_llvm_type, true);
     } else if (old_type == AST::ValueTypePrimitive::t_int8 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateSIToFP(value, new_llvm_type));
+        return llvm_builder->CreateSIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int16 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateSIToFP(value, new_llvm_type));
+        return llvm_builder->CreateSIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int32 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateSIToFP(value, new_llvm_type));
+        return llvm_builder->CreateSIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int64 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateSIToFP(value, new_llvm_type));
+        return llvm_builder->CreateSIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int8 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateSIToFP(value, new_llvm_type));
+        return llvm_builder->CreateSIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int16 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateSIToFP(value, new_llvm_type));
+        return llvm_builder->CreateSIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int32 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateSIToFP(value, new_llvm_type));
+        return llvm_builder->CreateSIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_int64 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateSIToFP(value, new_llvm_type));
+        return llvm_builder->CreateSIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint8 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateUIToFP(value, new_llvm_type));
+        return llvm_builder->CreateUIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint16 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateUIToFP(value, new_llvm_type));
+        return llvm_builder->CreateUIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint32 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateUIToFP(value, new_llvm_type));
+        return llvm_builder->CreateUIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint64 && new_type == AST::ValueTypePrimitive::t_float32) {
-        value_stack.push(llvm_builder->CreateUIToFP(value, new_llvm_type));
+        return llvm_builder->CreateUIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint8 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateUIToFP(value, new_llvm_type));
+        return llvm_builder->CreateUIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint16 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateUIToFP(value, new_llvm_type));
+        return llvm_builder->CreateUIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint32 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateUIToFP(value, new_llvm_type));
+        return llvm_builder->CreateUIToFP(value, new_llvm_type);
     } else if (old_type == AST::ValueTypePrimitive::t_uint64 && new_type == AST::ValueTypePrimitive::t_float64) {
-        value_stack.push(llvm_builder->CreateUIToFP(value, new_llvm_type));
+        return llvm_builder->CreateUIToFP(value, new_llvm_type);
     } else {
         throw std::runtime_error("Unsupported type cast");
     }
@@ -226,34 +485,57 @@ llvm::Type *LLVMCompiler::get_llvm_type(AST::ValueTypePrimitive type)
 
 void LLVMCompiler::visitVarDecl(AST::VarDeclNode &node)
 {
-    auto varname = node.name();
     llvm::Type* type = get_llvm_type(node.type_node()->type.get_primitive_type());
-
-    // alloc the variable on the stack
-    llvm::AllocaInst* alloca = llvm_builder->CreateAlloca(type, nullptr, varname);
-
-    // store the variable in the map
-    var_map[&node] = alloca;
+    llvm::Value* init_value = nullptr;
 
     if (node.init_expr) {
-        node.init_expr->accept(*this);
+        dispatch(*node.init_expr);
 
         // check that the visited node pushed a value on the stack
         assert(value_stack.size() > 0 && "No value on the stack");
 
-        llvm::Value* init_value = value_stack.top();
+        init_value = emit_store_conversion(value_stack.top(), type);
+        value_stack.pop();
+    }
 
-        // if the type is a float but our init_value is a double we need to convert it
-        if (type->isFloatTy() && init_value->getType()->isDoubleTy()) {
-            init_value = llvm_builder->CreateFPTrunc(init_value, type);
-        }
-        else if (type->isDoubleTy() && init_value->getType()->isFloatTy()) {
-            init_value = llvm_builder->CreateFPExt(init_value, type);
+    var_map[&node] = emit_var_binding(node.name(), type, init_value);
+}
+
+llvm::Value *LLVMCompiler::emit_var_binding(llvm::StringRef name, llvm::Type *type, llvm::Value *init)
+{
+    if (init) {
+        if (!llvm::isa<llvm::Constant>(init) && !init->hasName()) {
+            init->setName(name);
         }
+        return init;
+    }
 
-        llvm_builder->CreateStore(init_value, alloca);
-        value_stack.pop();
+    // alloc the variable on the stack, always in the entry block, mem2reg only promotes allocas there
+    auto &entry = llvm_builder->GetInsertBlock()->getParent()->getEntryBlock();
+    llvm::IRBuilder<> entry_builder(&entry, entry.begin());
+    return entry_builder.CreateAlloca(type, nullptr, name);
+}
+
+llvm::Value *LLVMCompiler::emit_var_load(llvm::Value *binding)
+{
+    if (auto alloca = llvm::dyn_cast<llvm::AllocaInst>(binding)) {
+        return llvm_builder->CreateLoad(alloca->getAllocatedType(), alloca, alloca->getName());
+    }
+
+    return binding;
+}
+
+llvm::Value *LLVMCompiler::emit_store_conversion(llvm::Value *value, llvm::Type *type)
+{
+    // if the type is a float but our value is a double we need to convert it
+    if (type->isFloatTy() && value->getType()->isDoubleTy()) {
+        return llvm_builder->CreateFPTrunc(value, type);
+    }
+    else if (type->isDoubleTy() && value->getType()->isFloatTy()) {
+        return llvm_builder->CreateFPExt(value, type);
     }
+
+    return value;
 }
 
 void LLVMCompiler::visitVarRef(AST::VarRefNode &node)
@@ -282,51 +564,61 @@ void LLVMCompiler::visitLiteralIntExpr(AST::LiteralIntExprNode &node)
 
 void LLVMCompiler::visitLiteralBoolExpr(AST::LiteralBoolExprNode &node)
 {
+    value_stack.push(llvm::ConstantInt::get(*llvm_context, llvm::APInt(1, node.bool_value())));
 }
 
 void LLVMCompiler::visitBinaryExpr(AST::BinaryExprNode &node)
 {
-    node.lhs->accept(*this);
-    node.rhs->accept(*this);
-
-    auto lhsret =  node.lhs->result_type();
-    auto rhsret =  node.rhs->result_type();
+    dispatch(*node.lhs);
+    dispatch(*node.rhs);
 
     auto right = value_stack.top();
     value_stack.pop();
     auto left = value_stack.top();
     value_stack.pop();
 
-    if (lhsret.is_integer() && rhsret.is_integer()) 
+    value_stack.push(emit_binary(
+        node.op_node->op->type,
+        left, node.lhs->result_type().get_primitive_type(),
+        right, node.rhs->result_type().get_primitive_type()
+    ));
+}
+
+llvm::Value *LLVMCompiler::emit_binary(Token::Type op, llvm::Value *left, AST::ValueTypePrimitive left_type, llvm::Value *right, AST::ValueTypePrimitive right_type)
+{
+    // calls do not know their result type in the AST yet, the llvm type of the value is reliable
+    auto is_integer = [](llvm::Value *value, AST::ValueTypePrimitive type) {
+        return AST::ValueType(type).is_integer() || (type == AST::ValueTypePrimitive::t_void && value->getType()->isIntegerTy());
+    };
+
+    if (is_integer(left, left_type) && is_integer(right, right_type)) 
     {
-        switch (node.op_node->op->type) {
+        // division and comparison depend on the signedness of the operands
+        bool is_unsigned = AST::ValueType(left_type).is_unsigned_integer();
+
+        switch (op) {
             case Token::Type::t_op_add:
-                value_stack.push(llvm_builder->CreateAdd(left, right));
-                break;
+                return llvm_builder->CreateAdd(left, right);
             case Token::Type::t_op_sub:
-                value_stack.push(llvm_builder->CreateSub(left, right));
-                break;
+                return llvm_builder->CreateSub(left, right);
             case Token::Type::t_op_mul:
-                value_stack.push(llvm_builder->CreateMul(left, right));
-                break;
+                return llvm_builder->CreateMul(left, right);
             case Token::Type::t_op_div:
-                value_stack.push(llvm_builder->CreateSDiv(left, right));
-                break;
+                return is_unsigned ? llvm_builder->CreateUDiv(left, right) : llvm_builder->CreateSDiv(left, right);
             case Token::Type::t_op_mod:
-                value_stack.push(llvm_builder->CreateSRem(left, right));
-                break;
+                return is_unsigned ? llvm_builder->CreateURem(left, right) : llvm_builder->CreateSRem(left, right);
             case Token::Type::t_logical_eq:
-                value_stack.push(llvm_builder->CreateICmpEQ(left, right));
-                break;
+                return llvm_builder->CreateICmpEQ(left, right);
             case Token::Type::t_logical_neq:
-                value_stack.push(llvm_builder->CreateICmpNE(left, right));
-                break;
+                return llvm_builder->CreateICmpNE(left, right);
             case Token::Type::t_close_angle:
-                value_stack.push(llvm_builder->CreateICmpSGT(left, right));
-                break;
+                return is_unsigned ? llvm_builder->CreateICmpUGT(left, right) : llvm_builder->CreateICmpSGT(left, right);
             case Token::Type::t_open_angle:
-                value_stack.push(llvm_builder->CreateICmpSLT(left, right));
-                break;
+                return is_unsigned ? llvm_builder->CreateICmpULT(left, right) : llvm_builder->CreateICmpSLT(left, right);
+            case Token::Type::t_logical_geq:
+                return is_unsigned ? llvm_builder->CreateICmpUGE(left, right) : llvm_builder->CreateICmpSGE(left, right);
+            case Token::Type::t_logical_leq:
+                return is_unsigned ? llvm_builder->CreateICmpULE(left, right) : llvm_builder->CreateICmpSLE(left, right);
             default:
                 throw std::runtime_error("Unsupported binary operator");
         }
@@ -334,10 +626,10 @@ void LLVMCompiler::visitBinaryExpr(AST::BinaryExprNode &node)
     else 
     {
         // identify if the left or right value is a float and of what size
-        bool left_is_float = lhsret.is_primitive_of_type(AST::ValueTypePrimitive::t_float32);
-        bool right_is_float = rhsret.is_primitive_of_type(AST::ValueTypePrimitive::t_float32);
-        bool left_is_double = lhsret.is_primitive_of_type(AST::ValueTypePrimitive::t_float64);
-        bool right_is_double = rhsret.is_primitive_of_type(AST::ValueTypePrimitive::t_float64);
+        bool left_is_float = left_type == AST::ValueTypePrimitive::t_float32;
+        bool right_is_float = right_type == AST::ValueTypePrimitive::t_float32;
+        bool left_is_double = left_type == AST::ValueTypePrimitive::t_float64;
+        bool right_is_double = right_type == AST::ValueTypePrimitive::t_float64;
 
         if (left_is_float && right_is_double) {
             left = llvm_builder->CreateFPExt(left, llvm::Type::getDoubleTy(*llvm_context));
@@ -355,22 +647,30 @@ void LLVMCompiler::visitBinaryExpr(AST::BinaryExprNode &node)
             // throw std::runtime_error("Unsupported binary operator");
         }
 
-        switch (node.op_node->op->type) {
+        switch (op) {
             case Token::Type::t_op_add:
-                value_stack.push(llvm_builder->CreateFAdd(left, right));
-                break;
+                return llvm_builder->CreateFAdd(left, right);
             case Token::Type::t_op_sub:
-                value_stack.push(llvm_builder->CreateFSub(left, right));
-                break;
+                return llvm_builder->CreateFSub(left, right);
             case Token::Type::t_op_mul:
-                value_stack.push(llvm_builder->CreateFMul(left, right));
-                break;
+                return llvm_builder->CreateFMul(left, right);
             case Token::Type::t_op_div:
-                value_stack.push(llvm_builder->CreateFDiv(left, right));
-                break;
+                return llvm_builder->CreateFDiv(left, right);
             case Token::Type::t_op_mod:
-                value_stack.push(llvm_builder->CreateFRem(left, right));
-                break;
+                return llvm_builder->CreateFRem(left, right);
+            // ordered, a comparison with NaN is false, except for != which is true like in C
+            case Token::Type::t_logical_eq:
+                return llvm_builder->CreateFCmpOEQ(left, right);
+            case Token::Type::t_logical_neq:
+                return llvm_builder->CreateFCmpUNE(left, right);
+            case Token::Type::t_close_angle:
+                return llvm_builder->CreateFCmpOGT(left, right);
+            case Token::Type::t_open_angle:
+                return llvm_builder->CreateFCmpOLT(left, right);
+            case Token::Type::t_logical_geq:
+                return llvm_builder->CreateFCmpOGE(left, right);
+            case Token::Type::t_logical_leq:
+                return llvm_builder->CreateFCmpOLE(left, right);
             default:
                 throw std::runtime_error("Unsupported binary operator");
         }
@@ -379,55 +679,54 @@ void LLVMCompiler::visitBinaryExpr(AST::BinaryExprNode &node)
 
 void LLVMCompiler::visitUnaryExpr(AST::UnaryExprNode &node)
 {
+    dispatch(*node.expr);
+
+    auto value = value_stack.top();
+    value_stack.pop();
+
+    value_stack.push(emit_unary(node.token_operator.type(), value));
+}
+
+llvm::Value *LLVMCompiler::emit_unary(Token::Type op, llvm::Value *value)
+{
+    // increment and decrement need assignable operands, which expressions do not have yet
+    if (op != Token::Type::t_op_sub) {
+        throw std::runtime_error("Unsupported unary operator");
+    }
+
+    if (value->getType()->isFloatingPointTy()) {
+        return llvm_builder->CreateFNeg(value);
+    }
+
+    return llvm_builder->CreateNeg(value);
 }
 
 void LLVMCompiler::visitFunctionCallExpr(AST::FunctionCallExprNode &node)
 {
-    if (node.token_function_name.value() == "echo") {
+    if (node.token_function_name.type() == Token::Type::t_echo) {
 
         for (auto &arg : node.arguments) {
-            arg->accept(*this);
+            dispatch(*arg);
 
             auto arg_value = value_stack.top();
             value_stack.pop();
 
-            // printf each argument value
-            std::vector<llvm::Value *> ArgsV;
-
-            if (arg_value->getType()->isFloatTy()) {
-                ArgsV.push_back(llvm_builder->CreateGlobalStringPtr("%f\n"));
-                llvm::Value* printed_value = llvm_builder->CreateFPExt(arg_value, llvm::Type::getDoubleTy(*llvm_context), "toDouble");
-                ArgsV.push_back(printed_value);
-            } else if (arg_value->getType()->isDoubleTy()) {
-                ArgsV.push_back(llvm_builder->CreateGlobalStringPtr("%f\n"));
-                ArgsV.push_back(arg_value);
-            } else if (arg_value->getType()->isIntegerTy()) {
-                ArgsV.push_back(llvm_builder->CreateGlobalStringPtr("%d\n"));
-                ArgsV.push_back(arg_value);
-            } else if (arg_value->getType()->isIntegerTy(1)) {
-                ArgsV.push_back(llvm_builder->CreateGlobalStringPtr("%d\n"));
-                ArgsV.push_back(arg_value);
-            } else if (arg_value->getType()->isPointerTy()) {
-                ArgsV.push_back(llvm_builder->CreateGlobalStringPtr("%s\n"));
-                ArgsV.push_back(arg_value);
-            } else {
-                throw std::runtime_error("Unsupported argument type for 'echo'");
-            }
-
-            llvm_builder->CreateCall(llvm_module->getFunction("printf"), ArgsV);
+            emit_echo(arg_value, arg->result_type().get_primitive_type());
         }
     }
 
     else 
     {
-        llvm::Function *func = llvm_module->getFunction(node.token_function_name.value());
-        if (!func) {
+        auto found = function_map.find(node.token_function_name.symbol());
+        if (found == function_map.end()) {
             throw std::runtime_error("Function not found");
         }
 
+        llvm::Function *func = found->second;
+
         std::vector<llvm::Value *> args;
         for (auto &arg : node.arguments) {
-            arg->accept(*this);
+            dispatch(*arg);
             args.push_back(value_stack.top());
             value_stack.pop();
         }
@@ -438,15 +737,47 @@ void LLVMCompiler::visitFunctionCallExpr(AST::FunctionCallExprNode &node)
     }
 }
 
+void LLVMCompiler::emit_echo(llvm::Value *arg_value, AST::ValueTypePrimitive arg_type)
+{
+    // the runtime has a function per type, every one prints the value followed by a newline
+    auto *type = arg_value->getType();
+    const char *function;
+
+    // llvm integers have no sign, the AST type tells if a value has to be printed unsigned
+    bool is_unsigned = AST::ValueType(arg_type).is_unsigned_integer();
+
+    if (type->isFloatTy()) {
+        function = "echo_f64";
+        arg_value = llvm_builder->CreateFPExt(arg_value, llvm::Type::getDoubleTy(*llvm_context), "toDouble");
+    } else if (type->isDoubleTy()) {
+        function = "echo_f64";
+    } else if (type->isIntegerTy(1)) {
+        function = "echo_i32";
+        arg_value = llvm_builder->CreateZExt(arg_value, llvm_builder->getInt32Ty());
+    } else if (type->isIntegerTy(64)) {
+        function = is_unsigned ? "echo_u64" : "echo_i64";
+    } else if (type->isIntegerTy() && type->getIntegerBitWidth() <= 32 && is_unsigned) {
+        function = "echo_u32";
+        arg_value = llvm_builder->CreateZExt(arg_value, llvm_builder->getInt32Ty());
+    } else if (type->isIntegerTy() && type->getIntegerBitWidth() <= 32) {
+        function = "echo_i32";
+        arg_value = llvm_builder->CreateSExt(arg_value, llvm_builder->getInt32Ty());
+    } else if (type->isPointerTy()) {
+        function = "echo_str";
+    } else {
+        throw std::runtime_error("Unsupported argument type for 'echo'");
+    }
+
+    llvm_builder->CreateCall(llvm_module->getFunction(function), { arg_value });
+}
+
 void LLVMCompiler::visitVarRefExpr(AST::VarRefExprNode &node)
 {
     auto var_ref = node.var_ref;
-    llvm::AllocaInst *var = var_map[var_ref->decl];
+    llvm::Value *var = var_map[var_ref->decl];
+    assert(var && "variable used before its declaration has been emitted");
 
-    llvm::Type *type = var->getAllocatedType();
-    llvm::Value* varval = llvm_builder->CreateLoad(type, var, var->getName());
-
-    value_stack.push(varval);
+    value_stack.push(emit_var_load(var));
 }
 
 void LLVMCompiler::visitNull(AST::NullNode &node)
@@ -457,41 +788,82 @@ void LLVMCompiler::visitOperator(AST::OperatorNode &node)
 {
 }
 
-void LLVMCompiler::visitFunctionDecl(AST::FunctionDeclNode &node)
+llvm::Function *LLVMCompiler::declare_function(AST::FunctionDeclNode &node)
 {
+    if (node.name_token.has_value()) {
+        auto found = function_map.find(node.name_token->symbol());
+        if (found != function_map.end()) {
+            return found->second;
+        }
+    }
+
     AST::TypeNode *return_type = node.return_type;
     assert(return_type && "Function return type is not set");
-    llvm::Type *llvm_return_type = get_llvm_type(return_type->type.get_primitive_type());
 
-    std::vector<llvm::Type *> arg_types;
+    std::vector<AST::ValueTypePrimitive> arg_types;
     for (auto &arg : node.args) {
-        arg_types.push_back(get_llvm_type(arg->type_node()->type.get_primitive_type()));
+        arg_types.push_back(arg->type_node()->type.get_primitive_type());
     }
 
-    llvm::FunctionType *func_type = llvm::FunctionType::get(llvm_return_type, arg_types, false);
-    llvm::Function *func = llvm::Function::Create(func_type, llvm::Function::ExternalLinkage, node.func_name(), llvm_module.get());
+    llvm::Function *func = emit_function_prototype(node.func_name(), return_type->type.get_primitive_type(), arg_types);
 
-    llvm::BasicBlock *entry = llvm::BasicBlock::Create(*llvm_context, "entry", func);
-    llvm_builder->SetInsertPoint(entry);
+    if (node.name_token.has_value()) {
+        function_map[node.name_token->symbol()] = func;
+    }
+
+    return func;
+}
+
+void LLVMCompiler::visitFunctionDecl(AST::FunctionDeclNode &node)
+{
+    llvm::Function *func = declare_function(node);
 
-    // create the arguments
+    std::vector<llvm::StringRef> arg_names;
+    for (auto &arg : node.args) {
+        arg_names.push_back(arg->name());
+    }
+    emit_function_entry(func, arg_names);
+
+    // the arguments are bound to their SSA values directly
     for (auto &arg : func->args()) {
-        arg.setName(node.args[arg.getArgNo()]->name());
-        llvm::AllocaInst *alloca = llvm_builder->CreateAlloca(arg.getType(), nullptr, arg.getName());
-        llvm_builder->CreateStore(&arg, alloca);
-        var_map[node.args[arg.getArgNo()]] = alloca;
+        var_map[node.args[arg.getArgNo()]] = &arg;
     }
 
     // visit the function body
-    node.body->accept(*this);
+    dispatch(*node.body);
 
     // terminate the function
     // llvm_builder->CreateRetVoid();
 }
 
+void LLVMCompiler::emit_function_entry(llvm::Function *func, const std::vector<llvm::StringRef> &arg_names)
+{
+    llvm::BasicBlock *entry = llvm::BasicBlock::Create(*llvm_context, "entry", func);
+    llvm_builder->SetInsertPoint(entry);
+
+    for (auto &arg : func->args()) {
+        arg.setName(arg_names[arg.getArgNo()]);
+    }
+}
+
+llvm::Function *LLVMCompiler::emit_function_prototype(const std::string &name, AST::ValueTypePrimitive return_type, const std::vector<AST::ValueTypePrimitive> &arg_types)
+{
+    std::vector<llvm::Type *> llvm_arg_types;
+    for (auto arg_type : arg_types) {
+        llvm_arg_types.push_back(get_llvm_type(arg_type));
+    }
+
+    llvm::FunctionType *func_type = llvm::FunctionType::get(get_llvm_type(return_type), llvm_arg_types, false);
+    llvm::Function *func = llvm::Function::Create(func_type, llvm::Function::ExternalLinkage, name, llvm_module.get());
+
+    // tells the functions of the program apart from runtime and entry functions
+    func->addFnAttr(echo_function_attribute);
+    return func;
+}
+
 void LLVMCompiler::visitReturn(AST::ReturnNode &node)
 {
-    node.expr->accept(*this);
+    dispatch(*node.expr);
 
     llvm::Value *ret = value_stack.top();
     value_stack.pop();
@@ -503,32 +875,43 @@ void LLVMCompiler::visitIfStatement(AST::IfStatementNode &node)
 {
     for(auto &block : node.blocks)
     {
-        bool has_condition = block.condition != nullptr;
-        auto scope = block.block;
-
-        llvm::BasicBlock *if_block = llvm::BasicBlock::Create(*llvm_context, "if", llvm_builder->GetInsertBlock()->getParent());
-        llvm::BasicBlock *else_block = llvm::BasicBlock::Create(*llvm_context, "else", llvm_builder->GetInsertBlock()->getParent());
-        llvm::BasicBlock *merge_block = llvm::BasicBlock::Create(*llvm_context, "merge", llvm_builder->GetInsertBlock()->getParent());
+        std::function<llvm::Value *()> condition;
+        if (block.condition != nullptr) {
+            condition = [this, &block]() {
+                dispatch(*block.condition);
+                llvm::Value *value = value_stack.top();
+                value_stack.pop();
+                return value;
+            };
+        }
 
-        if (has_condition) {
-            block.condition->accept(*this);
-            llvm::Value *condition = value_stack.top();
-            value_stack.pop();
+        emit_if_block(condition, [this, &block]() { dispatch(*block.block); });
+    }
+}
 
-            llvm_builder->CreateCondBr(condition, if_block, else_block);
-        } else {
-            llvm_builder->CreateBr(if_block);
-        }
+void LLVMCompiler::emit_if_block(const std::function<llvm::Value *()> &condition, const std::function<void()> &body)
+{
+    llvm::BasicBlock *if_block = llvm::BasicBlock::Create(*llvm_context, "if", llvm_builder->GetInsertBlock()->getParent());
+    llvm::BasicBlock *else_block = llvm::BasicBlock::Create(*llvm_context, "else", llvm_builder->GetInsertBlock()->getParent());
+    llvm::BasicBlock *merge_block = llvm::BasicBlock::Create(*llvm_context, "merge", llvm_builder->GetInsertBlock()->getParent());
 
-        llvm_builder->SetInsertPoint(if_block);
-        scope->accept(*this);
-        llvm_builder->CreateBr(merge_block);
+    if (condition) {
+        llvm_builder->CreateCondBr(condition(), if_block, else_block);
+    } else {
+        llvm_builder->CreateBr(if_block);
+    }
 
-        llvm_builder->SetInsertPoint(else_block);
+    llvm_builder->SetInsertPoint(if_block);
+    body();
+    // the block might already end with a return
+    if (!llvm_builder->GetInsertBlock()->getTerminator()) {
         llvm_builder->CreateBr(merge_block);
-        
-        llvm_builder->SetInsertPoint(merge_block);
     }
+
+    llvm_builder->SetInsertPoint(else_block);
+    llvm_builder->CreateBr(merge_block);
+    
+    llvm_builder->SetInsertPoint(merge_block);
 }
 
 void LLVMCompiler::printIR(bool toFile)
@@ -540,108 +923,307 @@ void LLVMCompiler::printIR(bool toFile)
             llvm::errs() << "Could not open file: " << EC.message() << '\n';
             return;
         }
-        llvm_module->print(outFile, nullptr);
+        for (auto &unit : units) {
+            unit.module->print(outFile, nullptr);
+        }
         outFile.close();
     } else {
-        llvm_module->print(llvm::outs(), nullptr);
+        for (auto &unit : units) {
+            unit.module->print(llvm::outs(), nullptr);
+        }
     }
 }
 
-void LLVMCompiler::run_code() {
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
-    llvm::InitializeNativeTargetAsmParser();
+llvm::orc::LLLazyJIT &LLVMCompiler::get_jit()
+{
+    if (jit && jit_opt_level == opt_level && jit_cpu == target_cpu && jit_features == target_features) {
+        return *jit;
+    }
 
-    std::string errorStr;
-    const llvm::TargetOptions opts;
-    llvm::ExecutionEngine *EE = llvm::EngineBuilder(std::move(llvm_module))
-                                .setErrorStr(&errorStr)
-                                .setEngineKind(llvm::EngineKind::JIT)
-                                .setTargetOptions(opts)
-                                .create();
+    auto created = llvm::orc::LLLazyJITBuilder()
+        .setJITTargetMachineBuilder(make_target_builder(opt_level))
+        .create();
 
-    if (!EE) {
-        llvm::errs() << "Failed to create ExecutionEngine: " << errorStr << '\n';
-        return;
+    if (!created) {
+        throw std::runtime_error("Failed to create the JIT: " + llvm::toString(created.takeError()));
     }
 
-    EE->finalizeObject();
+    jit = std::move(*created);
+    jit_opt_level = opt_level;
+    jit_cpu = target_cpu;
+    jit_features = target_features;
+    return *jit;
+}
+
+llvm::orc::JITTargetMachineBuilder LLVMCompiler::make_target_builder(OptLevel level) const
+{
+    llvm::orc::JITTargetMachineBuilder builder { llvm::Triple(llvm::sys::getProcessTriple()) };
 
-    auto *func = EE->FindFunctionNamed("main");
-    if (!func) {
-        llvm::errs() << "Function 'main' not found in module.\n";
-        return;
+    builder.setCPU(target_cpu.empty() ? llvm::sys::getHostCPUName().str() : target_cpu);
+
+    // an explicit cpu brings its own default features, the host features only go with the host cpu
+    std::vector<std::string> features;
+    if (target_features.empty() && target_cpu.empty()) {
+        llvm::StringMap<bool> host_features;
+        if (llvm::sys::getHostCPUFeatures(host_features)) {
+            for (auto &feature : host_features) {
+                features.push_back((feature.second ? "+" : "-") + feature.first().str());
+            }
+        }
+    } else if (!target_features.empty()) {
+        llvm::SmallVector<llvm::StringRef, 16> parts;
+        llvm::StringRef(target_features).split(parts, ',', -1, false);
+        for (auto part : parts) {
+            features.push_back(part.trim().str());
+        }
     }
+    builder.addFeatures(features);
 
-    std::vector<llvm::GenericValue> noargs;
-    llvm::GenericValue gv = EE->runFunction(func, noargs);
+    builder.setCodeGenOptLevel(codegen_level(level));
+    return builder;
+}
 
-    llvm::outs() << "Function 'main' executed.\n";
+llvm::orc::JITDylib *LLVMCompiler::create_run_dylib(llvm::orc::LLLazyJIT &lazy_jit, const std::string &name)
+{
+    auto dylib = lazy_jit.createJITDylib(name);
+    if (!dylib) {
+        llvm::errs() << "Failed to create JITDylib: " << llvm::toString(dylib.takeError()) << '\n';
+        return nullptr;
+    }
 
-    delete EE;
-    llvm::llvm_shutdown();
+    // resolve the runtime functions from the host process, the compiler links the runtime itself
+    auto process_symbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(lazy_jit.getDataLayout().getGlobalPrefix());
+    if (!process_symbols) {
+        llvm::errs() << "Failed to load process symbols: " << llvm::toString(process_symbols.takeError()) << '\n';
+        return nullptr;
+    }
+    dylib->addGenerator(std::move(*process_symbols));
+
+    return &*dylib;
 }
 
-void LLVMCompiler::make_exec(std::string executable_name)
+int LLVMCompiler::run_code() 
 {
-    // llvm::InitializeAllTargetInfos();
-    // llvm::InitializeAllTargets();
-    // llvm::InitializeAllTargetMCs();
-    // llvm::InitializeAllAsmParsers();
-    // llvm::InitializeAllAsmPrinters();
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
-    llvm::InitializeNativeTargetAsmParser();
+    if (!profile_generate.empty()) {
+        llvm::errs() << "Instrumented programs need the profile runtime, link them into an executable instead\n";
+        return 1;
+    }
+
+    auto &lazy_jit = get_jit();
+
+    // every run gets a fresh dylib, the symbols of the previous runs (main etc.) would clash otherwise
+    auto dylib = create_run_dylib(lazy_jit, "echo_run_" + std::to_string(jit_run_count++));
+    if (!dylib) {
+        return 1;
+    }
+
+    if (object_cache) {
+        emit_objects();
+
+        for (auto &object : objects) {
+            if (auto err = lazy_jit.addObjectFile(*dylib, std::move(object))) {
+                llvm::errs() << "Failed to add object to the JIT: " << llvm::toString(std::move(err)) << '\n';
+                return 1;
+            }
+        }
+    } else {
+        // the JIT takes over the modules and their contexts, functions are compiled on their first call
+        for (auto &unit : units) {
+            auto tsm = llvm::orc::ThreadSafeModule(std::move(unit.module), std::move(unit.context));
+
+            if (auto err = lazy_jit.addLazyIRModule(*dylib, std::move(tsm))) {
+                llvm::errs() << "Failed to add module to the JIT: " << llvm::toString(std::move(err)) << '\n';
+                return 1;
+            }
+        }
+    }
+    units.clear();
+    objects.clear();
+
+    auto main_symbol = lazy_jit.lookup(*dylib, "main");
+    if (!main_symbol) {
+        llvm::errs() << "Function 'main' not found in module: " << llvm::toString(main_symbol.takeError()) << '\n';
+        return 1;
+    }
 
+    char program_name[] = "echo";
+    char *argv[] = { program_name, nullptr };
 
+    auto *main_func = main_symbol->toPtr<int(int, char **)>();
+    int exit_code = main_func(1, argv);
 
-    auto TargetTriple = llvm::sys::getDefaultTargetTriple();
-    // auto TargetTriple = "aarch64-linux-gnu";
+    llvm::outs() << "Function 'main' executed.\n";
 
-    std::string Error;
-    auto Target = llvm::TargetRegistry::lookupTarget(TargetTriple, Error);
-    if (!Target) {
-        llvm::errs() << Error;
+    return exit_code;
+}
+
+void LLVMCompiler::for_each_unit(ThreadPool *pool, const std::function<void(CompiledUnit &)> &task)
+{
+    if (pool == nullptr || units.size() < 2) {
+        for (auto &unit : units) {
+            task(unit);
+        }
         return;
     }
 
-    auto CPU = "generic";
-    auto Features = "";
+    for (auto &unit : units) {
+        pool->submit([&task, &unit]() { task(unit); });
+    }
+    pool->wait();
+}
+
+bool LLVMCompiler::make_exec(const std::string &output_path, ThreadPool *pool)
+{
+    emit_objects(pool);
+    if (objects.empty()) {
+        return false;
+    }
+
+    // the objects only live until the linker is done with them
+    std::vector<std::string> object_paths;
+    auto remove_objects = [&object_paths]() {
+        for (auto &path : object_paths) {
+            llvm::sys::fs::remove(path);
+        }
+    };
+
+    for (auto &object : objects) {
+        int fd;
+        llvm::SmallString<128> path;
+        if (auto err = llvm::sys::fs::createTemporaryFile("echo", "o", fd, path)) {
+            llvm::errs() << "Could not create object file: " << err.message() << '\n';
+            remove_objects();
+            return false;
+        }
+
+        llvm::raw_fd_ostream dest(fd, true);
+        dest << object->getBuffer();
+        object_paths.push_back(path.str().str());
+    }
+
+    bool linked = link_executable(output_path, object_paths);
+    remove_objects();
+
+    return linked;
+}
 
-    llvm::TargetOptions opt;
-    auto TargetMachine = Target->createTargetMachine(TargetTriple, CPU, Features, opt, llvm::Reloc::PIC_);
+bool LLVMCompiler::link_executable(const std::string &output_path, const std::vector<std::string> &object_paths)
+{
+    auto program = llvm::sys::findProgramByName(linker);
+    if (!program) {
+        llvm::errs() << "Linker '" << linker << "' not found: " << program.getError().message() << '\n';
+        return false;
+    }
 
-    llvm_module->setDataLayout(TargetMachine->createDataLayout());
-    llvm_module->setTargetTriple(TargetTriple);
+    // the C compiler driver knows where the C runtime and the start files are
+    std::vector<llvm::StringRef> args = { linker, "-o", output_path };
+    if (static_link) {
+        args.push_back("-static");
+    }
+    // links the profile runtime which writes the counters when the program exits
+    if (!profile_generate.empty()) {
+        args.push_back("-fprofile-instr-generate");
+    }
+    for (auto &path : object_paths) {
+        args.push_back(path);
+    }
+    args.push_back(runtime_archive);
+
+    std::string error;
+    int result = llvm::sys::ExecuteAndWait(*program, args, {}, {}, 0, 0, &error);
+    if (result != 0) {
+        llvm::errs() << "Linking " << output_path << " failed";
+        if (!error.empty()) {
+            llvm::errs() << ": " << error;
+        }
+        llvm::errs() << '\n';
+        return false;
+    }
 
-    auto Filename = "output.o";
-    std::error_code EC;
-    llvm::raw_fd_ostream dest(Filename, EC, llvm::sys::fs::OF_None);
+    return true;
+}
 
-    if (EC) {
-        llvm::errs() << "Could not open file: " << EC.message();
+void LLVMCompiler::emit_objects(ThreadPool *pool)
+{
+    // loaded from the cache or already emitted
+    if (!objects.empty()) {
         return;
     }
 
+    objects.resize(units.size());
+    for_each_unit(pool, [this](CompiledUnit &unit) {
+        objects[&unit - units.data()] = emit_object(*unit.module, opt_level);
+    });
+
+    for (auto &object : objects) {
+        if (!object) {
+            objects.clear();
+            return;
+        }
+    }
+
+    if (object_cache && !pending_cache_key.empty()) {
+        object_cache->store(pending_cache_key, objects);
+        pending_cache_key.clear();
+    }
+}
+
+std::unique_ptr<llvm::MemoryBuffer> LLVMCompiler::emit_object(llvm::Module &module, OptLevel level)
+{
+    // target machines are not thread safe, so every unit gets its own
+    auto target_builder = make_target_builder(level);
+    // objects are position independent and use the small code model, unlike the JIT default,
+    // so the same object can be linked into an executable or loaded into the JIT
+    target_builder.setRelocationModel(llvm::Reloc::PIC_);
+    target_builder.setCodeModel(llvm::CodeModel::Small);
+
+    auto created = target_builder.createTargetMachine();
+    if (!created) {
+        llvm::errs() << "Failed to create the target machine: " << llvm::toString(created.takeError()) << '\n';
+        return nullptr;
+    }
+    auto TargetMachine = std::move(*created);
+
+    module.setDataLayout(TargetMachine->createDataLayout());
+    module.setTargetTriple(TargetMachine->getTargetTriple().str());
+
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream dest(buffer);
+
     llvm::legacy::PassManager pass;
     auto FileType = llvm::CodeGenFileType::ObjectFile;
 
     if (TargetMachine->addPassesToEmitFile(pass, dest, nullptr, FileType)) {
         llvm::errs() << "TargetMachine can't emit a file of this type";
-        return;
+        return nullptr;
     }
 
-    pass.run(*llvm_module);
-    dest.flush();
+    pass.run(module);
+
+    return llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(buffer.data(), buffer.size()), module.getModuleIdentifier());
 }
 
-void LLVMCompiler::optimize() {
-    if (!llvm_module) {
-        llvm::errs() << "Module is not initialized.\n";
-        return;
+void LLVMCompiler::optimize_module(llvm::Module &module, OptLevel level)
+{
+    // with the target machine the passes know the cost model of the target, the vectorizer
+    // can only use the wider registers of the CPU this way
+    auto target_machine = make_target_builder(level).createTargetMachine();
+    if (target_machine) {
+        module.setDataLayout((*target_machine)->createDataLayout());
+        module.setTargetTriple((*target_machine)->getTargetTriple().str());
+    } else {
+        llvm::errs() << "Optimizing without target information: " << llvm::toString(target_machine.takeError()) << '\n';
     }
 
-    llvm::PassBuilder passBuilder;
+    // the instrumentation and the profile are applied by the pipelines PassBuilder builds
+    std::optional<llvm::PGOOptions> pgo;
+    if (!profile_generate.empty()) {
+        pgo = llvm::PGOOptions(profile_generate, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRInstr);
+    } else if (!profile_use.empty()) {
+        pgo = llvm::PGOOptions(profile_use, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRUse);
+    }
+
+    llvm::PassBuilder passBuilder(target_machine ? target_machine->get() : nullptr, llvm::PipelineTuningOptions(), pgo);
     llvm::LoopAnalysisManager loopAM;
     llvm::FunctionAnalysisManager functionAM;
     llvm::CGSCCAnalysisManager cgsccAM;
@@ -653,10 +1235,20 @@ void LLVMCompiler::optimize() {
     passBuilder.registerLoopAnalyses(loopAM);
     passBuilder.crossRegisterProxies(loopAM, functionAM, cgsccAM, moduleAM);
 
-    // make the pipeline
-    llvm::ModulePassManager modulePM = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
-    // llvm::ModulePassManager modulePM = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O0);
+    // make the pipeline, unoptimized code still gets the remaining stack slots promoted
+    // to registers, mem2reg is cheap and removes most of the memory round trips
+    llvm::ModulePassManager modulePM;
+    if (level == OptLevel::O0) {
+        modulePM.addPass(llvm::createModuleToFunctionPassAdaptor(llvm::PromotePass()));
 
-    
-    modulePM.run(*llvm_module, moduleAM);
+        // the O0 pipeline adds nothing but the instrumentation or the profile, the
+        // counters are placed on the promoted code just like the optimized pipelines do
+        if (pgo) {
+            modulePM.addPass(passBuilder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0));
+        }
+    } else {
+        modulePM = passBuilder.buildPerModuleDefaultPipeline(pipeline_level(level));
+    }
+
+    modulePM.run(module, moduleAM);
 }
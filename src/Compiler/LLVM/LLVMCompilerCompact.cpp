@@ -0,0 +1,220 @@
+#include "Compiler/LLVM/LLVMCompiler.h"
+
+/**
+ * Code generation from the compact trees of the files
+ *
+ * Produces the same IR as the node visitor, but walks the index based structure
+ * of arrays instead of chasing node pointers through virtual calls.
+ */
+
+void LLVMCompiler::compile_bundle_compact(const AST::Bundle &bundle)
+{
+    if (load_cached_objects(bundle, "compact")) {
+        return;
+    }
+
+    begin_compile();
+
+    const auto &symbols = *bundle.modules.symbols;
+
+    // first emit all function declarations
+    for (auto &module : bundle.modules) {
+        for (auto &file : module->files()) {
+            const auto &tree = file.compact;
+            if (tree.root == AST::cnode_none) {
+                throw std::runtime_error("File '" + file.get_path().string() + "' has no compact tree, it has to be parsed with `ModuleParser::lower_compact`");
+            }
+
+            compact_vars.assign(tree.vardecls.symbol.size(), nullptr);
+
+            auto root = tree.scopes.children[AST::cnode_index(tree.root)];
+            for (auto it = tree.begin(root); it != tree.end(root); ++it) {
+                if (AST::cnode_kind(*it) == AST::CompactKind::c_func_decl) {
+                    compact_function(tree, symbols, *it);
+                }
+            }
+        }
+    }
+
+    begin_main_function();
+
+    for (auto &module : bundle.modules) {
+        for (auto &file : module->files()) {
+            const auto &tree = file.compact;
+            compact_vars.assign(tree.vardecls.symbol.size(), nullptr);
+            compact_statement(tree, symbols, tree.root);
+        }
+    }
+
+    end_main_function();
+
+    finish_unit();
+}
+
+void LLVMCompiler::compact_function(const AST::CompactTree &tree, const SymbolTable &symbols, AST::cnode_t node)
+{
+    auto index = AST::cnode_index(node);
+    auto name = tree.functions.name[index];
+    auto args = tree.functions.args[index];
+
+    std::vector<AST::ValueTypePrimitive> arg_types;
+    for (auto it = tree.begin(args); it != tree.end(args); ++it) {
+        arg_types.push_back(tree.vardecls.type[AST::cnode_index(*it)]);
+    }
+
+    auto func_name = name != no_symbol ? std::string(symbols.name(name)) : "[anonymous]";
+    llvm::Function *func = emit_function_prototype(func_name, tree.functions.return_type[index], arg_types);
+
+    if (name != no_symbol) {
+        function_map[name] = func;
+    }
+
+    std::vector<llvm::StringRef> arg_names;
+    for (auto it = tree.begin(args); it != tree.end(args); ++it) {
+        auto arg_name = symbols.name(tree.vardecls.symbol[AST::cnode_index(*it)]);
+        arg_names.push_back(llvm::StringRef(arg_name.data(), arg_name.size()));
+    }
+    emit_function_entry(func, arg_names);
+
+    // the arguments are bound to their SSA values directly
+    for (auto &arg : func->args()) {
+        compact_vars[AST::cnode_index(tree.children[args.begin + arg.getArgNo()])] = &arg;
+    }
+
+    compact_statement(tree, symbols, tree.functions.body[index]);
+}
+
+void LLVMCompiler::compact_statement(const AST::CompactTree &tree, const SymbolTable &symbols, AST::cnode_t node)
+{
+    auto index = AST::cnode_index(node);
+
+    switch (AST::cnode_kind(node))
+    {
+        case AST::CompactKind::c_none:
+            break;
+
+        case AST::CompactKind::c_scope: {
+            auto children = tree.scopes.children[index];
+            for (auto it = tree.begin(children); it != tree.end(children); ++it) {
+                // functions have been emitted upfront
+                if (AST::cnode_kind(*it) != AST::CompactKind::c_func_decl) {
+                    compact_statement(tree, symbols, *it);
+                }
+            }
+            break;
+        }
+
+        case AST::CompactKind::c_vardecl: {
+            llvm::Type *type = get_llvm_type(tree.vardecls.type[index]);
+            auto name = symbols.name(tree.vardecls.symbol[index]);
+
+            llvm::Value *init_value = nullptr;
+            auto init = tree.vardecls.init[index];
+            if (init != AST::cnode_none) {
+                init_value = emit_store_conversion(compact_expr(tree, init), type);
+            }
+
+            compact_vars[index] = emit_var_binding(llvm::StringRef(name.data(), name.size()), type, init_value);
+            break;
+        }
+
+        case AST::CompactKind::c_return: {
+            llvm_builder->CreateRet(compact_expr(tree, tree.returns.expr[index]));
+            break;
+        }
+
+        case AST::CompactKind::c_if: {
+            auto blocks = tree.ifs.blocks[index];
+            for (uint32_t i = 0; i < blocks.count; i += 2)
+            {
+                auto condition = tree.children[blocks.begin + i];
+                auto scope = tree.children[blocks.begin + i + 1];
+
+                std::function<llvm::Value *()> emit_condition;
+                if (condition != AST::cnode_none) {
+                    emit_condition = [this, &tree, condition]() { return compact_expr(tree, condition); };
+                }
+
+                emit_if_block(emit_condition, [this, &tree, &symbols, scope]() { compact_statement(tree, symbols, scope); });
+            }
+            break;
+        }
+
+        // everything else is an expression statement
+        default:
+            compact_expr(tree, node);
+            break;
+    }
+}
+
+llvm::Value *LLVMCompiler::compact_expr(const AST::CompactTree &tree, AST::cnode_t node)
+{
+    auto index = AST::cnode_index(node);
+
+    switch (AST::cnode_kind(node))
+    {
+        case AST::CompactKind::c_literal_int: {
+            auto int_size = AST::get_integer_size(tree.int_literals.type[index]);
+            return llvm::ConstantInt::get(*llvm_context, llvm::APInt(int_size.size * 8, tree.int_literals.value[index], int_size.is_signed));
+        }
+
+        case AST::CompactKind::c_literal_float: {
+            auto value = tree.float_literals.value[index];
+            if (tree.float_literals.type[index] == AST::ValueTypePrimitive::t_float64) {
+                return llvm::ConstantFP::get(*llvm_context, llvm::APFloat(value));
+            }
+            return llvm::ConstantFP::get(*llvm_context, llvm::APFloat(static_cast<float>(value)));
+        }
+
+        case AST::CompactKind::c_literal_bool:
+            return llvm::ConstantInt::get(*llvm_context, llvm::APInt(1, tree.bool_literals.value[index]));
+
+        case AST::CompactKind::c_varref: {
+            llvm::Value *var = compact_vars[tree.varrefs.decl[index]];
+            assert(var && "variable used before its declaration has been emitted");
+            return emit_var_load(var);
+        }
+
+        case AST::CompactKind::c_binary: {
+            auto lhs = tree.binaries.lhs[index];
+            auto rhs = tree.binaries.rhs[index];
+            auto left = compact_expr(tree, lhs);
+            auto right = compact_expr(tree, rhs);
+            return emit_binary(tree.binaries.op[index], left, tree.result_type(lhs), right, tree.result_type(rhs));
+        }
+
+        case AST::CompactKind::c_unary:
+            return emit_unary(tree.unaries.op[index], compact_expr(tree, tree.unaries.expr[index]));
+
+        case AST::CompactKind::c_cast: {
+            auto expr = tree.casts.expr[index];
+            return emit_cast(compact_expr(tree, expr), tree.result_type(expr), tree.casts.type[index]);
+        }
+
+        case AST::CompactKind::c_call: {
+            auto args = tree.calls.args[index];
+
+            if (tree.calls.callee_type[index] == Token::Type::t_echo) {
+                for (auto it = tree.begin(args); it != tree.end(args); ++it) {
+                    emit_echo(compact_expr(tree, *it), tree.result_type(*it));
+                }
+                return nullptr;
+            }
+
+            auto found = function_map.find(tree.calls.callee[index]);
+            if (found == function_map.end()) {
+                throw std::runtime_error("Function not found");
+            }
+
+            std::vector<llvm::Value *> arg_values;
+            for (auto it = tree.begin(args); it != tree.end(args); ++it) {
+                arg_values.push_back(compact_expr(tree, *it));
+            }
+
+            return llvm_builder->CreateCall(found->second, arg_values);
+        }
+
+        default:
+            throw std::runtime_error("Unsupported expression in compact tree");
+    }
+}
@@ -0,0 +1,274 @@
+#include "Compiler/LLVM/LLVMCompiler.h"
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+
+#include <atomic>
+
+/**
+ * Tiered execution
+ *
+ * Every call to a function of the program goes through its slot, a global holding the address
+ * of the function, which makes the slots our indirect stubs. Tier 0 runs the units as they are
+ * compiled by the JIT with fast instruction selection, every function counts its calls in the
+ * prologue and reports itself once the counter reaches the threshold. The background thread
+ * then rebuilds the function from the bitcode of its unit, optimizes it, compiles it at full
+ * speed and stores the new address in the slot. Calls already running finish in the old code,
+ * every following call lands in the optimized one.
+ */
+
+struct LLVMCompiler::TieredState
+{
+    LLVMCompiler *compiler = nullptr;
+
+    std::unique_ptr<llvm::orc::LLLazyJIT> jit;
+    llvm::orc::JITDylib *dylib = nullptr;
+
+    // the units with the calls routed through the slots but without the counters
+    std::vector<llvm::SmallVector<char, 0>> unit_bitcode;
+
+    struct Function {
+        std::string name;
+        size_t unit;
+    };
+
+    // indexed by the id the counter of the function reports
+    std::vector<Function> functions;
+
+    std::atomic<size_t> optimized_count = 0;
+
+    // recompiles one hot function at a time, declared last so
+    // it is joined before anything the tasks use is destroyed
+    ThreadPool background { 1 };
+};
+
+static std::string slot_name(llvm::StringRef function) {
+    return (function + ".slot").str();
+}
+
+static std::string optimized_name(llvm::StringRef function) {
+    return (function + ".tier1").str();
+}
+
+// the slots are written from the background thread while the program reads them
+static const llvm::Align slot_align(alignof(void *));
+
+// replaces every direct call of a program function with a call through its slot, functions of
+// other units only get their slot declared, the slot is defined next to the function
+static void route_calls_through_slots(llvm::Module &module, const char *attribute)
+{
+    std::vector<llvm::Function *> functions;
+    for (auto &function : module) {
+        if (function.hasFnAttribute(attribute)) {
+            functions.push_back(&function);
+        }
+    }
+
+    for (auto *function : functions) {
+        auto *slot_type = function->getType();
+        auto *slot = new llvm::GlobalVariable(
+            module, slot_type, false, llvm::GlobalValue::ExternalLinkage,
+            function->isDeclaration() ? nullptr : function,
+            slot_name(function->getName())
+        );
+        slot->setAlignment(slot_align);
+
+        std::vector<llvm::CallInst *> calls;
+        for (auto *user : function->users()) {
+            auto *call = llvm::dyn_cast<llvm::CallInst>(user);
+            if (call && call->getCalledOperand() == function) {
+                calls.push_back(call);
+            }
+        }
+
+        for (auto *call : calls) {
+            llvm::IRBuilder<> builder(call);
+            auto *target = builder.CreateAlignedLoad(slot_type, slot, slot_align, function->getName());
+            target->setAtomic(llvm::AtomicOrdering::Monotonic);
+            call->setCalledOperand(target);
+        }
+    }
+}
+
+int LLVMCompiler::run_code_tiered()
+{
+    // objects loaded from the cache cannot be instrumented anymore, neither can
+    // programs instrumented for profiling which have to be linked with the profile runtime
+    if (units.empty() || !profile_generate.empty()) {
+        return run_code();
+    }
+
+    // a previous run might still be optimizing
+    if (tiered) {
+        tiered->background.wait();
+    }
+
+    tiered = std::make_shared<TieredState>();
+    auto &state = *tiered;
+    state.compiler = this;
+
+    // tier 0 is about getting started quickly
+    auto target_builder = make_target_builder(OptLevel::O0);
+    target_builder.getOptions().EnableFastISel = true;
+
+    auto created = llvm::orc::LLLazyJITBuilder()
+        .setJITTargetMachineBuilder(std::move(target_builder))
+        .create();
+
+    if (!created) {
+        throw std::runtime_error("Failed to create the JIT: " + llvm::toString(created.takeError()));
+    }
+    state.jit = std::move(*created);
+
+    state.dylib = create_run_dylib(*state.jit, "echo_tiered");
+    if (!state.dylib) {
+        return 1;
+    }
+
+    auto threshold = std::max<uint64_t>(tier_up_threshold, 1);
+
+    for (size_t unit_index = 0; unit_index < units.size(); unit_index++) {
+        auto &unit = units[unit_index];
+        auto &context = *unit.context;
+        auto &module = *unit.module;
+
+        route_calls_through_slots(module, echo_function_attribute);
+
+        llvm::raw_svector_ostream bitcode(state.unit_bitcode.emplace_back());
+        llvm::WriteBitcodeToFile(module, bitcode);
+
+        auto *int8_ptr_type = llvm::PointerType::get(llvm::Type::getInt8Ty(context), 0);
+        auto *int32_type = llvm::Type::getInt32Ty(context);
+        auto *int64_type = llvm::Type::getInt64Ty(context);
+
+        // the callback is called by address, there is no symbol to resolve
+        auto *callback_type = llvm::FunctionType::get(llvm::Type::getVoidTy(context), { int8_ptr_type, int32_type }, false);
+        auto *callback = llvm::ConstantExpr::getIntToPtr(
+            llvm::ConstantInt::get(int64_type, reinterpret_cast<uint64_t>(&LLVMCompiler::tier_up_callback)),
+            llvm::PointerType::get(callback_type, 0)
+        );
+        auto *state_ptr = llvm::ConstantExpr::getIntToPtr(llvm::ConstantInt::get(int64_type, reinterpret_cast<uint64_t>(&state)), int8_ptr_type);
+
+        for (auto &function : module) {
+            if (function.isDeclaration() || !function.hasFnAttribute(echo_function_attribute)) {
+                continue;
+            }
+
+            auto id = static_cast<uint32_t>(state.functions.size());
+            state.functions.push_back({ function.getName().str(), unit_index });
+
+            auto *counter = new llvm::GlobalVariable(
+                module, int64_type, false, llvm::GlobalValue::InternalLinkage,
+                llvm::ConstantInt::get(int64_type, 0), function.getName() + ".calls"
+            );
+
+            auto *body = &function.getEntryBlock();
+            auto *count_block = llvm::BasicBlock::Create(context, "tier.count", &function, body);
+            auto *tier_up_block = llvm::BasicBlock::Create(context, "tier.up", &function, body);
+
+            // only the call that reaches the threshold reports, so every function is queued once
+            llvm::IRBuilder<> builder(count_block);
+            auto *calls = builder.CreateAtomicRMW(
+                llvm::AtomicRMWInst::Add, counter, llvm::ConstantInt::get(int64_type, 1),
+                llvm::Align(8), llvm::AtomicOrdering::Monotonic
+            );
+            builder.CreateCondBr(builder.CreateICmpEQ(calls, llvm::ConstantInt::get(int64_type, threshold - 1)), tier_up_block, body);
+
+            builder.SetInsertPoint(tier_up_block);
+            builder.CreateCall(callback_type, callback, { state_ptr, llvm::ConstantInt::get(int32_type, id) });
+            builder.CreateBr(body);
+        }
+
+        auto tsm = llvm::orc::ThreadSafeModule(std::move(unit.module), std::move(unit.context));
+        if (auto err = state.jit->addLazyIRModule(*state.dylib, std::move(tsm))) {
+            llvm::errs() << "Failed to add module to the JIT: " << llvm::toString(std::move(err)) << '\n';
+            return 1;
+        }
+    }
+    units.clear();
+
+    auto main_symbol = state.jit->lookup(*state.dylib, "main");
+    if (!main_symbol) {
+        llvm::errs() << "Function 'main' not found in module: " << llvm::toString(main_symbol.takeError()) << '\n';
+        return 1;
+    }
+
+    char program_name[] = "echo";
+    char *argv[] = { program_name, nullptr };
+
+    auto *main_func = main_symbol->toPtr<int(int, char **)>();
+    int exit_code = main_func(1, argv);
+
+    state.background.wait();
+
+    llvm::outs() << "Function 'main' executed, " << state.optimized_count.load() << " hot functions optimized.\n";
+
+    return exit_code;
+}
+
+void LLVMCompiler::tier_up_callback(TieredState *state, uint32_t function)
+{
+    state->background.submit([state, function]() {
+        state->compiler->tier_up(*state, function);
+    });
+}
+
+void LLVMCompiler::tier_up(TieredState &state, uint32_t function_id)
+{
+    auto &function = state.functions[function_id];
+    auto &bitcode = state.unit_bitcode[function.unit];
+
+    llvm::LLVMContext context;
+    auto parsed = llvm::parseBitcodeFile(llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), function.name), context);
+    if (!parsed) {
+        llvm::errs() << "Failed to reload the unit of '" << function.name << "': " << llvm::toString(parsed.takeError()) << '\n';
+        return;
+    }
+    auto &module = **parsed;
+
+    // only the hot function is compiled again, it calls everything else through the
+    // slots of the running program, the only globals with external linkage
+    for (auto &other : module) {
+        if (!other.isDeclaration() && other.getName() != function.name) {
+            other.deleteBody();
+        }
+    }
+    for (auto &global : module.globals()) {
+        if (!global.hasLocalLinkage()) {
+            global.setInitializer(nullptr);
+        }
+    }
+
+    // renamed only after optimizing, a profile finds the function by its name
+    optimize_module(module, tier_up_level);
+
+    module.getFunction(function.name)->setName(optimized_name(function.name));
+
+    auto object = emit_object(module, tier_up_level);
+    if (!object) {
+        return;
+    }
+
+    if (auto err = state.jit->addObjectFile(*state.dylib, std::move(object))) {
+        llvm::errs() << "Failed to add the optimized '" << function.name << "' to the JIT: " << llvm::toString(std::move(err)) << '\n';
+        return;
+    }
+
+    auto optimized = state.jit->lookup(*state.dylib, optimized_name(function.name));
+    if (!optimized) {
+        llvm::errs() << "Optimized '" << function.name << "' not found: " << llvm::toString(optimized.takeError()) << '\n';
+        return;
+    }
+
+    auto slot = state.jit->lookup(*state.dylib, slot_name(function.name));
+    if (!slot) {
+        llvm::errs() << "Slot of '" << function.name << "' not found: " << llvm::toString(slot.takeError()) << '\n';
+        return;
+    }
+
+    auto *slot_address = slot->toPtr<void **>();
+    std::atomic_ref<void *>(*slot_address).store(optimized->toPtr<void *>(), std::memory_order_release);
+
+    state.optimized_count++;
+}
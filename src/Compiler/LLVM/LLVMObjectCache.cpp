@@ -0,0 +1,76 @@
+#include "Compiler/LLVM/LLVMObjectCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+static std::string object_filename(size_t index) {
+    return std::to_string(index) + ".o";
+}
+
+std::vector<std::unique_ptr<llvm::MemoryBuffer>> LLVMObjectCache::load(const std::string &key) const
+{
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects;
+
+    auto entry = _directory / key;
+    std::error_code ec;
+    if (!std::filesystem::is_directory(entry, ec)) {
+        return objects;
+    }
+
+    for (size_t i = 0; ; i++) {
+        auto path = entry / object_filename(i);
+        if (!std::filesystem::exists(path, ec)) {
+            break;
+        }
+
+        auto buffer = llvm::MemoryBuffer::getFile(path.string());
+        if (!buffer) {
+            llvm::errs() << "Failed to read cached object " << path.string() << ": " << buffer.getError().message() << '\n';
+            objects.clear();
+            break;
+        }
+
+        objects.push_back(std::move(*buffer));
+    }
+
+    return objects;
+}
+
+bool LLVMObjectCache::store(const std::string &key, const std::vector<std::unique_ptr<llvm::MemoryBuffer>> &objects) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(_directory, ec);
+    if (ec) {
+        llvm::errs() << "Failed to create the object cache directory: " << ec.message() << '\n';
+        return false;
+    }
+
+    // write everything into a unique directory first, renaming it publishes the entry
+    llvm::SmallString<256> staging;
+    if (auto err = llvm::sys::fs::createUniqueDirectory((_directory / (key + ".tmp")).string(), staging)) {
+        llvm::errs() << "Failed to create the object cache entry: " << err.message() << '\n';
+        return false;
+    }
+
+    auto staging_path = std::filesystem::path(staging.str().str());
+
+    for (size_t i = 0; i < objects.size(); i++) {
+        llvm::raw_fd_ostream out((staging_path / object_filename(i)).string(), ec, llvm::sys::fs::OF_None);
+        if (ec) {
+            llvm::errs() << "Failed to write cached object: " << ec.message() << '\n';
+            std::filesystem::remove_all(staging_path, ec);
+            return false;
+        }
+        out << objects[i]->getBuffer();
+    }
+
+    // another run might have stored the same entry in the meantime, its objects are identical
+    std::filesystem::rename(staging_path, _directory / key, ec);
+    if (ec) {
+        std::filesystem::remove_all(staging_path, ec);
+        return std::filesystem::is_directory(_directory / key, ec);
+    }
+
+    return true;
+}
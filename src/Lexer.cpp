@@ -13,13 +13,6 @@ constexpr bool is_numeric_char(char c) {
     return (c >= '0' && c <= '9');
 }
 
-constexpr bool is_valid_varname_char(char c) {
-    return (c >= 'a' && c <= 'z') || 
-           (c >= 'A' && c <= 'Z') || 
-           (c >= '0' && c <= '9') || 
-           (c == '_');
-}
-
 constexpr bool is_seperating_char(char c) {
     return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
            c == '(' || c == ')' || c == '{' || c == '}' ||
@@ -42,14 +35,6 @@ constexpr std::array<bool, 256> generate_numeric_lut() {
     return table;
 }
 
-constexpr std::array<bool, 256> generate_varname_lut() {
-    std::array<bool, 256> table = {};
-    for (size_t i = 0; i < 256; ++i) {
-        table[i] = is_valid_varname_char(static_cast<char>(i));
-    }
-    return table;
-}
-
 constexpr std::array<bool, 256> generate_seperating_lut() {
     std::array<bool, 256> table = {};
     for (size_t i = 0; i < 256; ++i) {
@@ -60,7 +45,6 @@ constexpr std::array<bool, 256> generate_seperating_lut() {
 
 constexpr auto hex_lut = generate_hex_lut();
 constexpr auto numeric_lut = generate_numeric_lut();
-constexpr auto varname_lut = generate_varname_lut();
 constexpr auto seperating_lut = generate_seperating_lut();
  
 void insert_function_into_tree(LexerFunction::TreeNode &root, const std::string &must_match, LexerFunction::Base *func, size_t prefix_limit = 3)
@@ -90,22 +74,55 @@ void sort_functiontree(LexerFunction::TreeNode &node)
     });
 }
 
-void Lexer::execute_functions(FunctionList &functions, TokenCollection &tokens, LexerCursor &cursor)
+const LexerFunction::TreeNode *LexerFunction::TreeNode::find_deepest(const LexerCursor &cursor, size_t &depth) const
 {
-    // we build a tree like structure based on the "must_match" string of each function
-    // we simply take the first N chars of the must match 
-    // im sure there is a better way to do this but works for now
-    auto fnc_tree_root = std::make_unique<LexerFunction::TreeNode>("root");
+    auto node = this;
+    depth = 0;
 
-    size_t prefix_limit = 3;
-    for (auto &func : functions) {
-        auto machter_stringns = func->must_match();
-        for (auto &match : machter_stringns) {
-            insert_function_into_tree(*fnc_tree_root.get(), match, func.get(), prefix_limit);
+    while (!cursor.is_eof()) {
+        auto child = node->children.find(cursor.peek(depth));
+        if (child == node->children.end()) {
+            break;
         }
+
+        node = child->second.get();
+        depth++;
     }
 
-    sort_functiontree(*fnc_tree_root.get());
+    return node;
+}
+
+// runs the given function lists in order of their priority, both lists are expected to be 
+// already sorted, this way we can merge the built-in and overlay functions without allocating
+bool run_functions_by_priority(
+    const std::vector<LexerFunction::Base *> *a, 
+    const std::vector<LexerFunction::Base *> *b, 
+    TokenCollection &tokens, 
+    LexerCursor &cursor
+) {
+    size_t ai = 0, bi = 0;
+    size_t asize = a ? a->size() : 0;
+    size_t bsize = b ? b->size() : 0;
+
+    while (ai < asize || bi < bsize) {
+        LexerFunction::Base *func;
+        if (bi >= bsize || (ai < asize && (*a)[ai]->priority() >= (*b)[bi]->priority())) {
+            func = (*a)[ai++];
+        } else {
+            func = (*b)[bi++];
+        }
+
+        if (func->parse(tokens, cursor)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Lexer::execute_functions(const LexerFunction::TreeNode *overlay_tree, TokenCollection &tokens, LexerCursor &cursor) const
+{
+    const auto &fnc_tree_root = *_function_tree;
 
     while (!cursor.is_eof()) 
     {
@@ -117,30 +134,38 @@ void Lexer::execute_functions(FunctionList &functions, TokenCollection &tokens,
             }
         }
 
-        auto node = fnc_tree_root.get();
-        auto peek_offset = 0;
-        while (!cursor.is_eof() && node->children.find(cursor.peek(peek_offset)) != node->children.end()) {
-            node = node->children[cursor.peek(peek_offset)].get();
-            peek_offset++;
+        // walk the built-in tree and the overlay, conceptually both are one tree 
+        // so the deeper match wins and on equal depth the functions of both nodes are considered
+        size_t depth = 0;
+        auto node = fnc_tree_root.find_deepest(cursor, depth);
+        const std::vector<LexerFunction::Base *> *node_functions = &node->functions;
+        const std::vector<LexerFunction::Base *> *overlay_functions = nullptr;
+        const std::vector<LexerFunction::Base *> *overlay_root_functions = nullptr;
+
+        if (overlay_tree) {
+            size_t overlay_depth = 0;
+            auto overlay_node = overlay_tree->find_deepest(cursor, overlay_depth);
+            overlay_root_functions = &overlay_tree->functions;
+
+            if (overlay_depth > depth) {
+                node_functions = nullptr;
+                overlay_functions = &overlay_node->functions;
+            } else if (overlay_depth == depth) {
+                overlay_functions = &overlay_node->functions;
+            }
         }
 
+        bool node_empty = (!node_functions || node_functions->empty()) && (!overlay_functions || overlay_functions->empty());
+
         bool matched = false;
 
-        if (node->functions.empty()) {
+        if (node_empty) {
             // run root functions
-            for (auto &func : fnc_tree_root->functions) {
-                if (func->parse(tokens, cursor)) {
-                    matched = true;
-                    break;
-                }
-            }
+            matched = run_functions_by_priority(&fnc_tree_root.functions, overlay_root_functions, tokens, cursor);
         }
 
-        for (auto &func : node->functions) {
-            if (func->parse(tokens, cursor)) {
-                matched = true;
-                break;
-            }
+        if (!matched) {
+            matched = run_functions_by_priority(node_functions, overlay_functions, tokens, cursor);
         }
 
         if (!matched) {
@@ -253,72 +278,140 @@ void Lexer::execute_functions(FunctionList &functions, TokenCollection &tokens,
 #define ECHO_LEX_FNC_CUST_STRING(name, lit, type) \
     name.push_back(std::make_unique<LexerFunction::StringToken>(lit, type));
 
-void Lexer::tokenize(TokenCollection &tokens, const std::string &input, const AST::OperatorRegistry *op_registry) 
+Lexer::Lexer()
+{
+    // build a list of lexer functions
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_semicolon);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_colon);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_comma);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_dot);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_logical_and);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_logical_or);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_logical_eq);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_logical_neq);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_logical_leq);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_logical_geq);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_assign);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_and);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_or);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_xor);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_op_inc);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_op_dec);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_op_shl);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_op_shr);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_op_add);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_op_sub);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_op_mul);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_op_div);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_op_mod);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_op_pow);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_qmark);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_exclamation);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_open_angle);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_close_angle);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_open_paren);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_close_paren);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_open_brace);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_close_brace);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_open_bracket);
+    ECHO_LEX_FNC_CHAR(_functions, Token::Type::t_close_bracket);
+    ECHO_LEX_FNC_CUST_STRING(_functions, "true", Token::Type::t_bool_literal);
+    ECHO_LEX_FNC_CUST_STRING(_functions, "false", Token::Type::t_bool_literal);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_const);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_echo);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_function);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_return);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_if);
+    ECHO_LEX_FNC_STRING(_functions, Token::Type::t_else);
+
+    _functions.push_back(std::make_unique<LexerFunction::NumericLiteral>());
+    _functions.push_back(std::make_unique<LexerFunction::StringLiteral>());
+    _functions.push_back(std::make_unique<LexerFunction::VariableName>());
+    _functions.push_back(std::make_unique<LexerFunction::HexLiteral>());
+    _functions.push_back(std::make_unique<LexerFunction::SingleLineComment>());
+    _functions.push_back(std::make_unique<LexerFunction::MultiLineComment>());
+    _functions.push_back(std::make_unique<LexerFunction::Identifier>());
+
+    // we build a tree like structure based on the "must_match" string of each function
+    // we simply take the first N chars of the must match 
+    // im sure there is a better way to do this but works for now
+    _function_tree = std::make_unique<LexerFunction::TreeNode>("root");
+
+    for (auto &func : _functions) {
+        for (auto &match : func->must_match()) {
+            insert_function_into_tree(*_function_tree, match, func.get(), MAX_PREFIX_LENGTH);
+        }
+    }
+
+    sort_functiontree(*_function_tree);
+
+    // the tree is only the blueprint, compile it into a flat state machine
+    _function_table = std::make_unique<LexerFunction::Table>(*_function_tree);
+}
+
+// interns the names of all identifiers and variables starting at the given token,
+// this is done in one batch so the shared symbol table is only locked once per input
+void intern_token_symbols(TokenCollection &tokens, size_t begin)
+{
+    std::vector<std::string_view> names;
+    std::vector<size_t> indices;
+
+    for (size_t i = begin; i < tokens.tokens.size(); i++) {
+        const auto &token = tokens.tokens[i];
+
+        if (token.type == Token::Type::t_identifier) {
+            names.push_back(tokens.value(token));
+        } 
+        // the symbol of a variable is its name without the "$" prefix
+        else if (token.type == Token::Type::t_varname) {
+            names.push_back(tokens.value(token).substr(1));
+        } 
+        else {
+            continue;
+        }
+
+        indices.push_back(i);
+    }
+
+    std::vector<symbol_t> symbols;
+    tokens.symbols->intern(names, symbols);
+
+    for (size_t i = 0; i < indices.size(); i++) {
+        tokens.tokens[indices[i]].symbol = symbols[i];
+    }
+}
+
+void Lexer::tokenize(TokenCollection &tokens, const std::string &input, const AST::OperatorRegistry *op_registry) const
+{
+    const auto source = tokens.add_owned_source(input);
+    tokenize_view(tokens, tokens.sources[source], op_registry);
+}
+
+void Lexer::tokenize_view(TokenCollection &tokens, std::string_view input, const AST::OperatorRegistry *op_registry) const
 {   
-    auto cursor = LexerCursor(input);
+    auto cursor = LexerCursor(input, tokens.add_source(input));
+
+    // if there are some custom operators we build a small overlay tree
+    // so that they are recognized, the built-in tree is shared and stays untouched
+    ECHO_LEX_MAKE_FNCLIST(lx_custom_functions);
+    std::unique_ptr<LexerFunction::TreeNode> overlay_tree;
+    std::unique_ptr<LexerFunction::Table> overlay_table;
+
+    if (op_registry && !op_registry->get_custom_operators().empty()) {
+        overlay_tree = std::make_unique<LexerFunction::TreeNode>("root");
 
-    // build a list of lexer functions
-    ECHO_LEX_MAKE_FNCLIST(lx_functions);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_semicolon);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_colon);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_comma);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_dot);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_logical_and);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_logical_or);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_logical_eq);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_logical_neq);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_logical_leq);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_logical_geq);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_assign);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_and);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_or);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_xor);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_op_inc);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_op_dec);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_op_shl);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_op_shr);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_op_add);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_op_sub);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_op_mul);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_op_div);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_op_mod);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_op_pow);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_qmark);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_exclamation);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_open_angle);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_close_angle);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_open_paren);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_close_paren);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_open_brace);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_close_brace);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_open_bracket);
-    ECHO_LEX_FNC_CHAR(lx_functions, Token::Type::t_close_bracket);
-    ECHO_LEX_FNC_CUST_STRING(lx_functions, "true", Token::Type::t_bool_literal);
-    ECHO_LEX_FNC_CUST_STRING(lx_functions, "false", Token::Type::t_bool_literal);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_const);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_echo);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_function);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_return);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_if);
-    ECHO_LEX_FNC_STRING(lx_functions, Token::Type::t_else);
-
-    lx_functions.push_back(std::make_unique<LexerFunction::NumericLiteral>());
-    lx_functions.push_back(std::make_unique<LexerFunction::StringLiteral>());
-    lx_functions.push_back(std::make_unique<LexerFunction::VariableName>());
-    lx_functions.push_back(std::make_unique<LexerFunction::HexLiteral>());
-    lx_functions.push_back(std::make_unique<LexerFunction::SingleLineComment>());
-    lx_functions.push_back(std::make_unique<LexerFunction::MultiLineComment>());
-    lx_functions.push_back(std::make_unique<LexerFunction::Identifier>());
-
-    // if there are some custom operators 
-    // we add them to the list of functions so that they are recognized
-    if (op_registry) {
         for (const auto op : op_registry->get_custom_operators()) {
-            ECHO_LEX_FNC_CUST_STRING(lx_functions, op->name, Token::Type::t_op_custom);
+            ECHO_LEX_FNC_CUST_STRING(lx_custom_functions, op->name, Token::Type::t_op_custom);
+            insert_function_into_tree(*overlay_tree, op->name, lx_custom_functions.back().get(), MAX_PREFIX_LENGTH);
         }
+
+        sort_functiontree(*overlay_tree);
+        overlay_table = std::make_unique<LexerFunction::Table>(*overlay_tree);
     }
 
-    execute_functions(lx_functions, tokens, cursor);
+    const auto first_token = tokens.size();
+    execute_table(overlay_table.get(), tokens, cursor);
+    intern_token_symbols(tokens, first_token);
 
     // recreate cursor for mig
     // cursor.reset();
@@ -408,7 +501,7 @@ void Lexer::tokenize(TokenCollection &tokens, const std::string &input, const AS
     // }
 }
 
-void Lexer::tokenize_prepass_operators(const std::string &input, AST::OperatorRegistry &op_registry)
+void Lexer::tokenize_prepass_operators(std::string_view input, AST::OperatorRegistry &op_registry) const
 {
     // in this prepass we really only care to find custom operators in the input
     // so we can register them and let the main tokenizer handle the rest
@@ -519,7 +612,7 @@ bool LexerCursor::is_seperating_char(size_t offset)
     return seperating_lut[peek(offset)];
 }
 
-std::string LexerCursor::get_code_sample(const std::string::const_iterator it, const uint32_t start_offset, const uint32_t end_offset) const
+std::string LexerCursor::get_code_sample(const std::string_view::const_iterator it, const uint32_t start_offset, const uint32_t end_offset) const
 {
     auto start = it - start_offset;
     auto end = it + end_offset;
@@ -549,17 +642,22 @@ const std::vector<std::string> LexerFunction::CharToken::must_match() const
     return { std::string(1, lit) };
 }
 
-bool LexerFunction::CharToken::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_char_token(TokenCollection &tokens, LexerCursor &cursor, char lit, Token::Type type)
 {
     if (cursor.peek() != lit) {
         return false;
     }
 
-    tokens.push(std::string(1, lit), type, cursor.line, cursor.char_offset);
+    tokens.push(cursor.source, cursor.offset(), 1, type, cursor.line, cursor.char_offset);
     cursor.skip();
     return true;
 }
 
+bool LexerFunction::CharToken::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_char_token(tokens, cursor, lit, type);
+}
+
 // --- StringToken ---
 // ----------------------------------------------------------------------------
 const std::vector<std::string> LexerFunction::StringToken::must_match() const
@@ -567,17 +665,22 @@ const std::vector<std::string> LexerFunction::StringToken::must_match() const
     return { lit };
 }
 
-bool LexerFunction::StringToken::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_string_token(TokenCollection &tokens, LexerCursor &cursor, std::string_view lit, Token::Type type)
 {
     if (!cursor.begins_with(lit)) {
         return false;
     }
 
-    tokens.push(lit, type, cursor.line, cursor.char_offset);
+    tokens.push(cursor.source, cursor.offset(), lit.size(), type, cursor.line, cursor.char_offset);
     cursor.skip(lit.size());
     return true;
 }
 
+bool LexerFunction::StringToken::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_string_token(tokens, cursor, lit, type);
+}
+
 // --- NumericLiteral ---
 // ----------------------------------------------------------------------------
 const std::vector<std::string> LexerFunction::NumericLiteral::must_match() const
@@ -585,69 +688,69 @@ const std::vector<std::string> LexerFunction::NumericLiteral::must_match() const
     return { "-", "" };
 }
 
-bool LexerFunction::NumericLiteral::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_numeric_literal(TokenCollection &tokens, LexerCursor &cursor)
 {
     const auto start_offset = cursor.char_offset;
     const auto start_line = cursor.line;
+    const auto start = cursor.current();
 
     bool is_negative = cursor.peek() == '-';
     size_t peek_offset = is_negative ? 1 : 0;
-    std::string value;
 
     // no number found, return false
-    if (!numeric_lut[cursor.peek(peek_offset)]) {
+    if (!numeric_lut[static_cast<unsigned char>(cursor.peek(peek_offset))]) {
         return false;
     }
 
     // skip the negative sign
     if (is_negative) {
-        value += '-';
         cursor.skip();
     }
 
-    while (!cursor.is_eof()) {
-        if (!numeric_lut[cursor.peek()]) {
-            break;
-        }
-        value += cursor.peek();
+    while (!cursor.is_eof() && numeric_lut[static_cast<unsigned char>(cursor.peek())]) {
         cursor.skip();
     }
 
     // if the next character is not a dot we have an integer
     if (cursor.peek() != '.') {
-        tokens.push(value, Token::Type::t_integer_literal, start_line, start_offset);
+        tokens.push(cursor.source, cursor.offset(start), cursor.current() - start, Token::Type::t_integer_literal, start_line, start_offset);
         return true;
     }
 
     // skip the dot
-    value += '.';
     cursor.skip();
+    const auto fraction_start = cursor.current();
 
     // we have a floating point number, so we need to find the fractional part
-    while (!cursor.is_eof()) {
-        if (!numeric_lut[cursor.peek()]) {
-            break;
-        }
-
-        value += cursor.peek();
+    while (!cursor.is_eof() && numeric_lut[static_cast<unsigned char>(cursor.peek())]) {
         cursor.skip();
     }
 
-    // if the last character is still a dot, we implicitly add a zero
-    if (value.back() == '.') {
-        value += '0';
-    }
+    // if there is no fractional part we implicitly add a zero, 
+    // thats the only case where the value differs from the source
+    const bool needs_zero = fraction_start == cursor.current();
 
     // our literal support a "f" suffix for float literals instead of double
-    if (cursor.peek() == 'f') {
-        value += 'f';
+    const bool is_float = cursor.peek() == 'f';
+    if (is_float) {
         cursor.skip();
     }
 
-    tokens.push(value, Token::Type::t_floating_literal, start_line, start_offset);
+    if (needs_zero) {
+        auto value = std::string(start, fraction_start) + (is_float ? "0f" : "0");
+        tokens.push(value, Token::Type::t_floating_literal, start_line, start_offset);
+        return true;
+    }
+
+    tokens.push(cursor.source, cursor.offset(start), cursor.current() - start, Token::Type::t_floating_literal, start_line, start_offset);
     return true;
 }
 
+bool LexerFunction::NumericLiteral::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_numeric_literal(tokens, cursor);
+}
+
 // --- StringLiteral ---
 // ----------------------------------------------------------------------------
 const std::vector<std::string> LexerFunction::StringLiteral::must_match() const
@@ -655,7 +758,7 @@ const std::vector<std::string> LexerFunction::StringLiteral::must_match() const
     return { "\"", "'" };
 }
 
-bool LexerFunction::StringLiteral::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_string_literal(TokenCollection &tokens, LexerCursor &cursor)
 {
     if (!cursor.is_quote()) {
         return false;
@@ -669,6 +772,9 @@ bool LexerFunction::StringLiteral::parse(TokenCollection &tokens, LexerCursor &c
     cursor.skip();
 
     while (true) {
+        // jump over the string body right to the next quote or escape
+        cursor.skip_to(LexerSIMD::find_any_of(cursor.data(), cursor.data_end(), quote, '\\'));
+
         if (cursor.is_eof()) {
             const auto sample = cursor.get_code_sample(start, 20);
             throw Lexer::UnterminatedStringException(sample, string_start_line, string_start_offset);
@@ -679,17 +785,20 @@ bool LexerFunction::StringLiteral::parse(TokenCollection &tokens, LexerCursor &c
             break;
         }
 
-        if (cursor.peek() == '\\') {
-            cursor.skip();
-        }
-
+        // skip the escape and the escaped character
+        cursor.skip();
         cursor.skip();
     }
 
-    tokens.push(std::string(start, cursor.current()), Token::Type::t_string_literal, string_start_line, string_start_offset);
+    tokens.push(cursor.source, cursor.offset(start), cursor.current() - start, Token::Type::t_string_literal, string_start_line, string_start_offset);
     return true;
 }
 
+bool LexerFunction::StringLiteral::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_string_literal(tokens, cursor);
+}
+
 // --- VariableName ---
 // ----------------------------------------------------------------------------
 const std::vector<std::string> LexerFunction::VariableName::must_match() const
@@ -697,7 +806,7 @@ const std::vector<std::string> LexerFunction::VariableName::must_match() const
     return { "$" };
 }
 
-bool LexerFunction::VariableName::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_variable_name(TokenCollection &tokens, LexerCursor &cursor)
 {
     if (cursor.peek() != '$') {
         return false;
@@ -706,15 +815,17 @@ bool LexerFunction::VariableName::parse(TokenCollection &tokens, LexerCursor &cu
     auto start_col = cursor.char_offset;
     auto start = cursor.current();
     cursor.skip();
+    cursor.skip_to(LexerSIMD::skip_varname(cursor.data(), cursor.data_end()));
 
-    while (!cursor.is_eof() && varname_lut[cursor.peek()]) {
-        cursor.skip();
-    }
-
-    tokens.push(std::string(start, cursor.current()), Token::Type::t_varname, cursor.line, start_col);
+    tokens.push(cursor.source, cursor.offset(start), cursor.current() - start, Token::Type::t_varname, cursor.line, start_col);
     return true;
 }
 
+bool LexerFunction::VariableName::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_variable_name(tokens, cursor);
+}
+
 // --- HexLiteral ---
 // ----------------------------------------------------------------------------
 const std::vector<std::string> LexerFunction::HexLiteral::must_match() const
@@ -722,23 +833,34 @@ const std::vector<std::string> LexerFunction::HexLiteral::must_match() const
     return { "0x", "0X" };
 }
 
-bool LexerFunction::HexLiteral::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_hex_literal(TokenCollection &tokens, LexerCursor &cursor)
 {
     auto start_offset = cursor.char_offset;
+    const auto start = cursor.current();
+
+    // the value is always normalized to a lower case "0x" prefix
+    const bool is_upper_prefix = cursor.peek(1) == 'X';
 
     cursor.skip(2);
-    std::string value = "0x";
 
-    while (hex_lut[cursor.peek()]) {
-        value += cursor.peek();
+    while (hex_lut[static_cast<unsigned char>(cursor.peek())]) {
         cursor.skip();
     }
 
-    tokens.push(value, Token::Type::t_hex_literal, cursor.line, start_offset);
+    if (is_upper_prefix) {
+        tokens.push("0x" + std::string(start + 2, cursor.current()), Token::Type::t_hex_literal, cursor.line, start_offset);
+    } else {
+        tokens.push(cursor.source, cursor.offset(start), cursor.current() - start, Token::Type::t_hex_literal, cursor.line, start_offset);
+    }
 
     return true;
 }
 
+bool LexerFunction::HexLiteral::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_hex_literal(tokens, cursor);
+}
+
 // --- SingleLineComment ---
 // ----------------------------------------------------------------------------
 const std::vector<std::string> LexerFunction::SingleLineComment::must_match() const
@@ -746,7 +868,7 @@ const std::vector<std::string> LexerFunction::SingleLineComment::must_match() co
     return { "//" };
 }
 
-bool LexerFunction::SingleLineComment::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_single_line_comment(TokenCollection &tokens, LexerCursor &cursor)
 {
     if (!cursor.begins_with("//")) {
         return false;
@@ -758,6 +880,11 @@ bool LexerFunction::SingleLineComment::parse(TokenCollection &tokens, LexerCurso
     return true;
 }
 
+bool LexerFunction::SingleLineComment::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_single_line_comment(tokens, cursor);
+}
+
 // --- MultiLineComment ---
 // ----------------------------------------------------------------------------
 const std::vector<std::string> LexerFunction::MultiLineComment::must_match() const
@@ -765,7 +892,7 @@ const std::vector<std::string> LexerFunction::MultiLineComment::must_match() con
     return { "/*" };
 }
 
-bool LexerFunction::MultiLineComment::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_multi_line_comment(TokenCollection &tokens, LexerCursor &cursor)
 {
     if (!cursor.begins_with("/*")) {
         return false;
@@ -775,7 +902,13 @@ bool LexerFunction::MultiLineComment::parse(TokenCollection &tokens, LexerCursor
 
     cursor.skip(2);
 
-    while (!cursor.is_eof()) {
+    while (true) {
+        cursor.skip_to(LexerSIMD::find_char(cursor.data(), cursor.data_end(), '*'));
+
+        if (cursor.is_eof()) {
+            break;
+        }
+
         if (cursor.begins_with("*/")) {
             cursor.skip(2);
             return true;
@@ -789,6 +922,11 @@ bool LexerFunction::MultiLineComment::parse(TokenCollection &tokens, LexerCursor
     throw Lexer::UnterminatedCommentException(extract, cursor.line, cursor.char_offset);
 }
 
+bool LexerFunction::MultiLineComment::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_multi_line_comment(tokens, cursor);
+}
+
 // --- Identifier ---
 // ----------------------------------------------------------------------------
 const std::vector<std::string> LexerFunction::Identifier::must_match() const
@@ -796,25 +934,220 @@ const std::vector<std::string> LexerFunction::Identifier::must_match() const
     return { "" };
 }
 
-bool LexerFunction::Identifier::parse(TokenCollection &tokens, LexerCursor &cursor) const
+inline bool lex_identifier(TokenCollection &tokens, LexerCursor &cursor)
 {
     auto start_offset = cursor.char_offset;
     auto start_line = cursor.line;
 
     const auto start = cursor.current();
+    cursor.skip_to(LexerSIMD::skip_varname(cursor.data(), cursor.data_end()));
+
+    // sanity check
+    if (start == cursor.current()) {
+        return false;
+    }
+
+    tokens.push(cursor.source, cursor.offset(start), cursor.current() - start, Token::Type::t_identifier, start_line, start_offset);
+    return true;
+}
+
+bool LexerFunction::Identifier::parse(TokenCollection &tokens, LexerCursor &cursor) const
+{
+    return lex_identifier(tokens, cursor);
+}
+
+/**
+ * Lexer Function Table
+ *
+ * ----------------------------------------------------------------------------
+ */
+LexerFunction::Table::Table(const TreeNode &root)
+{
+    // assign every node a state id in breadth first order, so the root ends up as state 0
+    std::vector<const TreeNode *> nodes = { &root };
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (const auto &child : nodes[i]->children) {
+            nodes.push_back(child.second.get());
+        }
+    }
+
+    assert(nodes.size() <= UINT16_MAX && "Too many lexer states");
+
+    _transitions.resize(nodes.size() * 256, 0);
+    _states.reserve(nodes.size());
+
+    std::unordered_map<const TreeNode *, uint16_t> state_ids;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        state_ids[nodes[i]] = static_cast<uint16_t>(i);
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i) 
+    {
+        const auto node = nodes[i];
+
+        for (const auto &child : node->children) {
+            _transitions[i * 256 + static_cast<unsigned char>(child.first)] = state_ids[child.second.get()];
+        }
+
+        // the functions of the node are already sorted by priority
+        State state;
+        state.candidates_begin = static_cast<uint32_t>(_candidates.size());
+
+        for (const auto func : node->functions) 
+        {
+            Candidate candidate;
+            candidate.kind = func->kind();
+            candidate.type = Token::Type::t_unknown;
+            candidate.priority = func->priority();
+            candidate.literal_offset = 0;
+            candidate.literal_size = 0;
+
+            if (candidate.kind == Kind::char_token) {
+                auto char_token = static_cast<const CharToken *>(func);
+                candidate.type = char_token->type;
+                candidate.literal_offset = static_cast<uint32_t>(_literals.size());
+                candidate.literal_size = 1;
+                _literals += char_token->lit;
+            } 
+            else if (candidate.kind == Kind::string_token) {
+                auto string_token = static_cast<const StringToken *>(func);
+                candidate.type = string_token->type;
+                candidate.literal_offset = static_cast<uint32_t>(_literals.size());
+                candidate.literal_size = static_cast<uint32_t>(string_token->lit.size());
+                _literals += string_token->lit;
+            }
+
+            _candidates.push_back(candidate);
+        }
+
+        state.candidates_end = static_cast<uint32_t>(_candidates.size());
+        _states.push_back(state);
+    }
+}
+
+uint16_t LexerFunction::Table::find_deepest(const LexerCursor &cursor, size_t &depth) const
+{
+    uint16_t state = root_state;
+    depth = 0;
 
     while (!cursor.is_eof()) {
-        if (!varname_lut[cursor.peek()]) {
+        auto next = transition(state, cursor.peek(depth));
+        if (next == 0) {
             break;
         }
-        cursor.skip();
+
+        state = next;
+        depth++;
     }
 
-    // sanity check
-    if (start == cursor.current()) {
-        return false;
+    return state;
+}
+
+inline bool run_candidate(const LexerFunction::Table &table, const LexerFunction::Table::Candidate &candidate, TokenCollection &tokens, LexerCursor &cursor)
+{
+    switch (candidate.kind) {
+        case LexerFunction::Kind::char_token:
+            return lex_char_token(tokens, cursor, table.literal(candidate)[0], candidate.type);
+        case LexerFunction::Kind::string_token:
+            return lex_string_token(tokens, cursor, table.literal(candidate), candidate.type);
+        case LexerFunction::Kind::numeric_literal:
+            return lex_numeric_literal(tokens, cursor);
+        case LexerFunction::Kind::hex_literal:
+            return lex_hex_literal(tokens, cursor);
+        case LexerFunction::Kind::string_literal:
+            return lex_string_literal(tokens, cursor);
+        case LexerFunction::Kind::variable_name:
+            return lex_variable_name(tokens, cursor);
+        case LexerFunction::Kind::single_line_comment:
+            return lex_single_line_comment(tokens, cursor);
+        case LexerFunction::Kind::multi_line_comment:
+            return lex_multi_line_comment(tokens, cursor);
+        case LexerFunction::Kind::identifier:
+            return lex_identifier(tokens, cursor);
     }
 
-    tokens.push(std::string(start, cursor.current()), Token::Type::t_identifier, start_line, start_offset);
-    return true;
+    return false;
+}
+
+// same as run_functions_by_priority but for the candidates of two table states
+bool run_candidates_by_priority(
+    const LexerFunction::Table &a_table, uint16_t a_state, bool a_enabled,
+    const LexerFunction::Table *b_table, uint16_t b_state, bool b_enabled,
+    TokenCollection &tokens, 
+    LexerCursor &cursor
+) {
+    auto ai = a_enabled ? a_table.candidates_begin(a_state) : nullptr;
+    auto aend = a_enabled ? a_table.candidates_end(a_state) : nullptr;
+    auto bi = b_enabled ? b_table->candidates_begin(b_state) : nullptr;
+    auto bend = b_enabled ? b_table->candidates_end(b_state) : nullptr;
+
+    while (ai != aend || bi != bend) {
+        bool matched;
+        if (bi == bend || (ai != aend && ai->priority >= bi->priority)) {
+            matched = run_candidate(a_table, *ai++, tokens, cursor);
+        } else {
+            matched = run_candidate(*b_table, *bi++, tokens, cursor);
+        }
+
+        if (matched) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Lexer::execute_table(const LexerFunction::Table *overlay_table, TokenCollection &tokens, LexerCursor &cursor) const
+{
+    const auto &table = *_function_table;
+    constexpr auto root = LexerFunction::Table::root_state;
+
+    while (!cursor.is_eof()) 
+    {
+        // formatting aka whitespace, tabs, newlines
+        if (cursor.is_formatting()) {
+            cursor.skip_formatting();
+            if (cursor.is_eof()) {
+                break;
+            }
+        }
+
+        // this mirrors execute_functions exactly, the deeper state wins 
+        // and on equal depth the candidates of both states are merged
+        size_t depth = 0;
+        auto state = table.find_deepest(cursor, depth);
+        bool state_enabled = true;
+        uint16_t overlay_state = root;
+        bool overlay_enabled = false;
+
+        if (overlay_table) {
+            size_t overlay_depth = 0;
+            overlay_state = overlay_table->find_deepest(cursor, overlay_depth);
+
+            if (overlay_depth > depth) {
+                state_enabled = false;
+                overlay_enabled = true;
+            } else if (overlay_depth == depth) {
+                overlay_enabled = true;
+            }
+        }
+
+        bool state_empty = (!state_enabled || !table.has_candidates(state)) && 
+                           (!overlay_enabled || !overlay_table->has_candidates(overlay_state));
+
+        bool matched = false;
+
+        if (state_empty) {
+            // run root candidates
+            matched = run_candidates_by_priority(table, root, true, overlay_table, root, overlay_table != nullptr, tokens, cursor);
+        }
+
+        if (!matched) {
+            matched = run_candidates_by_priority(table, state, state_enabled, overlay_table, overlay_state, overlay_enabled, tokens, cursor);
+        }
+
+        if (!matched) {
+            throw UnknownTokenException("Unexpected", cursor.line, cursor.char_offset );
+        }
+    }
 }
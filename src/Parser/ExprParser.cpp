@@ -7,24 +7,28 @@
 #include "AST/LiteralValueNode.h"
 #include "AST/TypeCastNode.h"
 
-#include "External/infint.h"
-
 #include "Parser/FuncCallParser.h"
 
+#include <cmath>
 #include <format>
+#include <limits>
 
-bool can_hold_literal_int(Parser::Payload &payload, AST::ValueType type, const std::string &literal, const TokenReference literal_token)
+bool can_hold_literal_int(Parser::Payload &payload, AST::ValueType type, const AST::LiteralIntExprNode &literal, const TokenReference literal_token)
 {
-    InfInt value(literal);
-
     auto int_size = AST::get_integer_size(type.get_primitive_type());
+    auto literal_value = literal.effective_token_literal_value();
 
-    if (value > int_size.get_max_positive_value()) {
+    // a literal that does not even fit into 128 bits is out of range for every type
+    bool is_negative = literal_value.starts_with('-');
+    bool too_large = literal.is_decoded ? literal.value > int_size.get_max_positive_value() : !is_negative;
+    bool too_small = literal.is_decoded ? literal.value < int_size.get_max_negative_value() : is_negative;
+
+    if (too_large) {
         payload.collector.collect_issue<AST::Issue::IntegerOverflow>(
             payload.context.code_ref(literal_token), 
             std::format(
                 "The literal '{}' is too large for the integer type '{}'. The maximum value is '{}'.", 
-                literal,
+                literal_value,
                 AST::get_primitive_name(type.get_primitive_type()),
                 int_size.get_max_positive_value()
             )
@@ -33,12 +37,12 @@ bool can_hold_literal_int(Parser::Payload &payload, AST::ValueType type, const s
         return false;
     }
 
-    if (value < int_size.get_max_negative_value()) {
+    if (too_small) {
         payload.collector.collect_issue<AST::Issue::IntegerUnderflow>(
             payload.context.code_ref(literal_token), 
             std::format(
                 "The literal '{}' is too small for the integer type '{}'. The minimum value is '{}'.", 
-                literal,
+                literal_value,
                 AST::get_primitive_name(type.get_primitive_type()),
                 int_size.get_max_negative_value()
             )
@@ -74,8 +78,8 @@ const AST::NodeReference parse_literal_float(Parser::Payload &payload, AST::Type
                 // we do a quick check if the literal would actually loose precision
                 // I personally see no point in annyoing the user with a warning if the literal is 1.0
                 // so if we can cast the double to float and back to double and the value is the same, we dont emit a warning
-                double dliteral = std::stod(node.get_fvalue_string());
-                float fliteral = (float) dliteral;
+                double dliteral = node.value_f64;
+                float fliteral = node.value_f32;
                 double dliteral2 = (double) fliteral;
 
                 if (dliteral != dliteral2) {
@@ -89,7 +93,7 @@ const AST::NodeReference parse_literal_float(Parser::Payload &payload, AST::Type
                     );
 
                     // override the literal value with the float value
-                    casted_node.override_literal_value.emplace(std::to_string(fliteral));
+                    casted_node.set_literal_value(std::to_string(fliteral));
                 }
             }
 
@@ -102,10 +106,7 @@ const AST::NodeReference parse_literal_float(Parser::Payload &payload, AST::Type
             // determine if the literal has any decimal values besides 0
             // if so, we emit a error (not just a warning) because the user highly likely made a mistake
             // or is expecting a wrong type.
-            double dliteral = std::stod(node.get_fvalue_string());
-            double dliteral_cmp = (double) (long long) dliteral;
-
-            if (dliteral != dliteral_cmp) {
+            if (node.value_f64 != std::trunc(node.value_f64)) {
                 payload.collector.collect_issue<AST::Issue::InvalidTypeConversion>(
                     payload.context.code_ref(current_token), 
                     std::format(
@@ -124,13 +125,13 @@ const AST::NodeReference parse_literal_float(Parser::Payload &payload, AST::Type
             // the int literal is simply the fvalue string with everything after the dot removed
             std::string int_literal = node.get_fvalue_string().substr(0, node.get_fvalue_string().find('.'));
 
-            if (!can_hold_literal_int(payload, expected_type->type, int_literal, current_token)) {
+            auto &casted_node = payload.context.emplace_node<AST::LiteralIntExprNode>(current_token, expected_type->type.get_primitive_type());
+            casted_node.set_literal_value(int_literal);
+
+            if (!can_hold_literal_int(payload, expected_type->type, casted_node, current_token)) {
                 return AST::make_void_ref();
             }
 
-            auto &casted_node = payload.context.emplace_node<AST::LiteralIntExprNode>(current_token, expected_type->type.get_primitive_type());
-            casted_node.override_literal_value.emplace(int_literal);
-
             return AST::make_ref(casted_node);
         }
         
@@ -153,17 +154,14 @@ const AST::NodeReference parse_literal_int(Parser::Payload &payload, AST::TypeNo
     auto &cursor = payload.cursor;
     auto current_token = cursor.current();
 
-    // we first check if the literal is larger then a 32bit integer, if so we automatically create a 64bit integer
-    InfInt intvalue(current_token.value());
-    auto guessed_int_type = AST::ValueTypePrimitive::t_int32;
+    auto &node = payload.context.emplace_node<AST::LiteralIntExprNode>(current_token);
+    cursor.skip();
 
-    if (intvalue > AST::get_integer_size(AST::ValueTypePrimitive::t_int32).get_max_positive_value()) {
-        guessed_int_type = AST::ValueTypePrimitive::t_int64;
+    // we first check if the literal is larger then a 32bit integer, if so we automatically create a 64bit integer
+    if (!node.is_decoded || node.value > AST::get_integer_size(AST::ValueTypePrimitive::t_int32).get_max_positive_value()) {
+        node.expected_primitive_type = AST::ValueTypePrimitive::t_int64;
     }
 
-    auto &node = payload.context.emplace_node<AST::LiteralIntExprNode>(current_token, guessed_int_type);
-    cursor.skip();
-
     // if there is a specified expected type, check if the literal fits the type
     if (expected_type != nullptr) 
     {
@@ -182,11 +180,9 @@ const AST::NodeReference parse_literal_int(Parser::Payload &payload, AST::TypeNo
         // integers
         else if (expected_type->type.is_integer())
         {
-            auto &expected_node = payload.context.emplace_node<AST::LiteralIntExprNode>(current_token, expected_type->type.get_primitive_type());
-
             // check if the expected type is unsigned and the literal is negative
             // which should throw an error
-            if (expected_type->type.is_unsigned_integer() && intvalue < 0) {
+            if (expected_type->type.is_unsigned_integer() && (node.is_decoded ? node.value < 0 : current_token.value().starts_with('-'))) {
                 payload.collector.collect_issue<AST::Issue::InvalidTypeConversion>(
                     payload.context.code_ref(current_token), 
                     std::format(
@@ -199,40 +195,14 @@ const AST::NodeReference parse_literal_int(Parser::Payload &payload, AST::TypeNo
             }
 
             // check if the literal fits the expected type
-            auto int_size = AST::get_integer_size(expected_type->type.get_primitive_type());
-            auto lower_bound = int_size.get_max_negative_value();
-            auto upper_bound = int_size.get_max_positive_value();
-
-            if (intvalue < lower_bound) {
-                payload.collector.collect_issue<AST::Issue::IntegerUnderflow>(
-                    payload.context.code_ref(current_token), 
-                    std::format(
-                        "The literal '{}' is too small for the integer type '{}'. The minimum value is '{}'.", 
-                        current_token.value(),
-                        AST::get_primitive_name(expected_type->type.get_primitive_type()),
-                        lower_bound
-                    )
-                );
-
+            if (!can_hold_literal_int(payload, expected_type->type, node, current_token)) {
                 return AST::make_void_ref();
             }
 
-            if (intvalue > upper_bound) {
-                payload.collector.collect_issue<AST::Issue::IntegerOverflow>(
-                    payload.context.code_ref(current_token), 
-                    std::format(
-                        "The literal '{}' is too large for the integer type '{}'. The maximum value is '{}'.", 
-                        current_token.value(),
-                        AST::get_primitive_name(expected_type->type.get_primitive_type()),
-                        upper_bound
-                    )
-                );
-
-                return AST::make_void_ref();
-            }
-
-            // if we end up here, the literal fits the expected type and can be used as expected
-            return AST::make_ref(expected_node);
+            // if we end up here, the literal fits the expected type and can be used as expected,
+            // the already decoded node just takes the expected type
+            node.expected_primitive_type = expected_type->type.get_primitive_type();
+            return AST::make_ref(node);
         }
 
         // cannot cast
@@ -256,19 +226,6 @@ AST::ExprNode *Parser::parse_expr(Parser::Payload &payload, AST::TypeNode *expec
     return ref.unsafe_ptr<AST::ExprNode>();
 }
 
-bool is_expr_token(Parser::Cursor &cursor)
-{
-    return cursor.is_type(Token::Type::t_floating_literal) ||
-           cursor.is_type(Token::Type::t_integer_literal) ||
-           cursor.is_type(Token::Type::t_bool_literal) ||
-           cursor.is_type(Token::Type::t_varname) || 
-           cursor.is_type(Token::Type::t_open_paren) || 
-           cursor.is_type(Token::Type::t_close_paren) || 
-           cursor.is_type(Token::Type::t_identifier) ||
-           // if the token has a operator precendence, it is a valid expression token
-           AST::Operator::get_precedence_for_token(cursor.current().type()).sequence > 0;
-}
-
 AST::ExprNode *try_implicit_cast(Parser::Payload &payload, AST::ExprNode *source, const AST::TypeNode *expected_type)
 {   
     // if the types match we can return the source node directly
@@ -298,10 +255,10 @@ const AST::NodeReference parse_expr_node(Parser::Payload &payload, AST::TypeNode
     }
 
     if (cursor.is_type(Token::Type::t_varname)) {
-        auto vardecl = payload.context.scope().find_vardecl_by_name(cursor.current().value());
+        auto vardecl = payload.context.scope().find_vardecl_by_symbol(cursor.current().symbol());
 
         if (!vardecl) {
-            payload.collector.collect_issue<AST::Issue::UnknownVariable>(payload.context.code_ref(cursor.current()), cursor.current().value());
+            payload.collector.collect_issue<AST::Issue::UnknownVariable>(payload.context.code_ref(cursor.current()), std::string(cursor.current().value()));
             cursor.skip();
             return AST::make_void_ref();
         }
@@ -333,216 +290,152 @@ const AST::NodeReference parse_expr_node(Parser::Payload &payload, AST::TypeNode
     assert(false && "unimplemented");
 }
 
-struct ExprPart {
-    // val node
-    const AST::NodeReference node;
-    // operator node
-    AST::OperatorNode *opnode;
-};
+// operators that only take one operand, "-" is only one when it starts an operand
+bool is_prefix_operator(const AST::Operator *op)
+{
+    return op->type == Token::Type::t_op_sub || 
+           op->type == Token::Type::t_op_inc || 
+           op->type == Token::Type::t_op_dec;
+}
+
+bool is_postfix_operator(const AST::Operator *op)
+{
+    return op->type == Token::Type::t_op_inc || 
+           op->type == Token::Type::t_op_dec;
+}
+
+// increment and decrement need an assignable operand, which expressions do not have yet,
+// they are still parsed so the rest of the expression is, but cannot be compiled
+void collect_unsupported_unary(Parser::Payload &payload, const TokenReference &token)
+{
+    if (token.type() == Token::Type::t_op_inc || token.type() == Token::Type::t_op_dec) {
+        payload.collector.collect_issue<AST::Issue::GenericError>(payload.context.code_ref(token), "increment and decrement operators are not supported yet");
+    }
+}
 
-#define O1Prec part.opnode->op->precedence
-#define O2Prec operator_stack.top()->op->precedence
+// unary operators bind tighter than every binary one
+static constexpr int unary_precedence = 2;
 
-std::vector<ExprPart> shunting_yard(const std::vector<ExprPart> &expr_parts)
+// the operator the cursor is on, nullptr at the end of the tokens or if it is not an operator
+const AST::Operator *current_operator(Parser::Payload &payload)
 {
-    auto output = std::vector<ExprPart>();
-    auto operator_stack = std::stack<AST::OperatorNode *>();
+    if (payload.cursor.is_done()) {
+        return nullptr;
+    }
 
-    for(auto part : expr_parts)
-    {
-        // if its a literal, variable etc. (not an operator)
-        if (part.opnode == nullptr) 
-        {
-            output.push_back(part);
-        }
-        else if (part.opnode->op->type == Token::Type::t_open_paren)
-        {
-            operator_stack.push(part.opnode);
+    return payload.collector.operators.get_operator(payload.cursor.current());
+}
+
+const AST::NodeReference parse_expr_precedence(Parser::Payload &payload, AST::TypeNode *expected_type, int max_sequence);
+
+// parses a single operand including its prefix operators and parentheses
+const AST::NodeReference parse_expr_operand(Parser::Payload &payload, AST::TypeNode *expected_type)
+{
+    auto &cursor = payload.cursor;
+
+    if (cursor.is_done()) {
+        payload.collector.collect_issue<AST::Issue::UnexpectedToken>(payload.context.code_ref(cursor.tokens[cursor.range_size() - 1]), Token::Type::t_unknown, Token::Type::t_unknown);
+        return AST::make_void_ref();
+    }
+
+    auto op = current_operator(payload);
+
+    if (op == nullptr) {
+        // literals, variables and function calls
+        if (cursor.is_type({ Token::Type::t_floating_literal, Token::Type::t_integer_literal, Token::Type::t_bool_literal, Token::Type::t_varname }) ||
+            cursor.is_type_sequence(0, { Token::Type::t_identifier, Token::Type::t_open_paren })
+        ) {
+            return parse_expr_node(payload, expected_type);
         }
-        else if (part.opnode->op->type == Token::Type::t_close_paren)
-        {
-            while (!operator_stack.empty() && operator_stack.top()->op->type != Token::Type::t_open_paren)
-            {
-                output.push_back({AST::make_void_ref(), operator_stack.top()});
-                operator_stack.pop();
-            }
+    }
+
+    // parentheses only group, they do not leave a node behind
+    else if (op->type == Token::Type::t_open_paren) {
+        cursor.skip();
 
-            // ensure we have the opening "(", otherwise something is off
-            assert(operator_stack.top()->op->type == Token::Type::t_open_paren);
-            operator_stack.pop();
+        auto inner = parse_expr_precedence(payload, expected_type, std::numeric_limits<int>::max());
+
+        if (!cursor.is_type(Token::Type::t_close_paren)) {
+            payload.collector.collect_issue<AST::Issue::UnexpectedToken>(payload.context.code_ref(cursor.is_done() ? cursor.tokens[cursor.range_size() - 1] : cursor.current()), Token::Type::t_close_paren, cursor.type());
+            return inner;
         }
-        else
-        {
-            while (
-                !operator_stack.empty() &&
-                // O2Prec.assoc != AST::OpAssociativity::left &&
-                operator_stack.top()->op->type != Token::Type::t_open_paren &&
-                (
-                    O2Prec.sequence < O1Prec.sequence ||
-                    (
-                        O1Prec.sequence == O2Prec.sequence &&
-                        O1Prec.assoc == AST::OpAssociativity::left
-                    )
-                )
-            ) {
-                output.push_back({AST::make_void_ref(), operator_stack.top()});
-                operator_stack.pop();
-            }
 
-            operator_stack.push(part.opnode);
-        }        
+        cursor.skip();
+        return inner;
     }
 
-    while (!operator_stack.empty())
-    {
-        output.push_back({AST::make_void_ref(), operator_stack.top()});
-        operator_stack.pop();
+    else if (is_prefix_operator(op)) {
+        auto token = cursor.current();
+        collect_unsupported_unary(payload, token);
+        cursor.skip();
+
+        auto operand = parse_expr_precedence(payload, expected_type, unary_precedence);
+        if (operand.node() == nullptr) {
+            return operand;
+        }
+
+        auto &node = payload.context.emplace_node<AST::UnaryExprNode>(token, operand.unsafe_ptr<AST::ExprNode>());
+        return AST::make_ref(node);
     }
 
-    return output;
+    // skip the token so callers looping over expressions always make progress
+    payload.collector.collect_issue<AST::Issue::UnexpectedToken>(payload.context.code_ref(cursor.current()), Token::Type::t_unknown, cursor.current().type());
+    cursor.skip();
+
+    return AST::make_void_ref();
 }
 
-const AST::NodeReference Parser::parse_expr_ref(Parser::Payload &payload, AST::TypeNode *expected_type)
+// precedence climbing, parses an operand followed by every operator whose precedence
+// sequence is at most `max_sequence` (lower sequences bind tighter), the right hand side of a
+// left associative operator is limited to tighter operators so equal ones are chained to the left
+const AST::NodeReference parse_expr_precedence(Parser::Payload &payload, AST::TypeNode *expected_type, int max_sequence)
 {
     auto &cursor = payload.cursor;
 
-    std::vector<ExprPart> expr_parts;
-
-    int depth = 0;
+    auto lhs = parse_expr_operand(payload, expected_type);
 
-    while(is_expr_token(cursor))
+    while (auto op = current_operator(payload)) 
     {
-        // if we have a closing parenthesis and the depth is 0, we can break the loop
-        // because we have reached the end of the expression
-        if (cursor.is_type(Token::Type::t_close_paren) && depth == 0) {
+        // a closing parenthesis ends the group, everything without a precedence ends the expression
+        if (op->precedence.sequence <= 1 || op->precedence.sequence > max_sequence) {
             break;
         }
 
-        // try to parse an operator
-        auto op = payload.collector.operators.get_operator(cursor.current());
-        auto &opnode = payload.context.emplace_node<AST::OperatorNode>(cursor.current(), op);
+        if (is_postfix_operator(op)) {
+            if (lhs.node() == nullptr) {
+                break;
+            }
 
-        if (op != nullptr) {
-            cursor.skip();
-            expr_parts.emplace_back(AST::make_void_ref(), &opnode);
+            collect_unsupported_unary(payload, cursor.current());
 
-            // if the operator is a open parenthesis, we increase the depth
-            if (op->type == Token::Type::t_open_paren) {
-                depth++;
-            } else if (op->type == Token::Type::t_close_paren) {
-                depth--;
-            }
+            auto &node = payload.context.emplace_node<AST::UnaryExprNode>(cursor.current(), lhs.unsafe_ptr<AST::ExprNode>(), true);
+            cursor.skip();
 
+            lhs = AST::make_ref(node);
             continue;
         }
 
-        // parse the next expression node
-        auto node = parse_expr_node(payload, expected_type);
-        expr_parts.emplace_back(node, nullptr);
-    }
-
-    // if we have only one part, we can return it directly
-    if (expr_parts.size() == 1) {
-        assert(expr_parts[0].opnode == nullptr && "expected no operator");
-        return expr_parts[0].node;
-    }
-
-    auto postfix_expr = shunting_yard(expr_parts);
+        auto &opnode = payload.context.emplace_node<AST::OperatorNode>(cursor.current(), op);
+        cursor.skip();
 
-    // build expressions nodes
-    std::stack<AST::NodeReference> node_stack;
-    for (auto &part : postfix_expr) 
-    {
-        if (part.opnode != nullptr) 
-        {
-            auto right = node_stack.top();
-            node_stack.pop();
+        auto rhs_max_sequence = op->precedence.assoc == AST::OpAssociativity::right
+            ? op->precedence.sequence
+            : op->precedence.sequence - 1;
 
-            auto left = node_stack.top();
-            node_stack.pop();
+        auto rhs = parse_expr_precedence(payload, expected_type, rhs_max_sequence);
 
-            auto &node = payload.context.emplace_node<AST::BinaryExprNode>(
-                part.opnode, 
-                left.unsafe_ptr<AST::ExprNode>(), 
-                right.unsafe_ptr<AST::ExprNode>()
-            );
-            node_stack.push(AST::make_ref(node));
-        }
-        else 
-        {
-            node_stack.push(part.node);
-        }
+        auto &node = payload.context.emplace_node<AST::BinaryExprNode>(
+            &opnode, 
+            lhs.unsafe_ptr<AST::ExprNode>(), 
+            rhs.unsafe_ptr<AST::ExprNode>()
+        );
+        lhs = AST::make_ref(node);
     }
 
-    // sanity check
-    assert(node_stack.size() == 1);
-    return node_stack.top();
-
-    // // print the postfix expression
-    // for (auto &part : postfix_expr) {
-    //     if (part.opnode != nullptr) {
-    //         std::cout << std::format("{} ", token_lit_symbol_string(part.opnode->op->type));
-    //     }
-    //     else {
-    //         if (part.node.has_type<AST::LiteralIntExprNode>()) {
-    //             std::cout << std::format("{} ", part.node.get<AST::LiteralIntExprNode>().effective_token_literal_value());
-    //         } else if (part.node.has_type<AST::LiteralFloatExprNode>()) {
-    //             std::cout << std::format("{} ", part.node.get<AST::LiteralFloatExprNode>().effective_token_literal_value());
-    //         } else if (part.node.has_type<AST::LiteralBoolExprNode>()) {
-    //             std::cout << std::format("{} ", part.node.get<AST::LiteralBoolExprNode>().effective_token_literal_value());
-    //         } else {
-    //             std::cout << std::format("{} ", part.node.node()->node_description());
-    //         }
-    //     }
-    // }
-
-
-    // // determine the token range of the expression
-    // while (!cursor.is_done()) {
-    //     if (!is_expr_token(cursor)) {
-    //         break;
-    //     }
-    //     cursor.skip();
-    // }
-
-    // auto cursor_after = cursor.snapshot();
-    // auto expr_slice = cursor.slice(cursor_before, cursor_after);
-    // cursor.restore(cursor_before);
-
-    // // collect the tokens in range and perform the shunting yard algorithm
-    // // to create a postfix expression
-    // auto postfix_expr = AST::Operator::shunting_yard(expr_slice);
-
-
-    // if (cursor.is_type(Token::Type::t_floating_literal)) {
-    //     return parse_literal_float(payload, expected_type);
-    // }
-
-    // if (cursor.is_type(Token::Type::t_integer_literal)) {
-    //     return parse_literal_int(payload, expected_type);
-    // }
-
-    // if (cursor.is_type(Token::Type::t_bool_literal)) {
-    //     auto &node = payload.context.emplace_node<AST::LiteralBoolExprNode>(cursor.current());
-    //     cursor.skip();
-    //     return AST::make_ref(node);
-    // }
-
-    // if (cursor.is_type(Token::Type::t_varname)) {
-    //     auto vardecl = payload.context.scope().find_vardecl_by_name(cursor.current().value());
-
-    //     if (!vardecl) {
-    //         payload.collector.collect_issue<AST::Issue::UnknownVariable>(payload.context.code_ref(cursor.current()), cursor.current().value());
-    //         cursor.skip();
-    //         return AST::make_void_ref();
-    //     }   
-
-    //     auto &varref = payload.context.emplace_node<AST::VarRefNode>(cursor.current(), vardecl);
-    //     auto &node = payload.context.emplace_node<AST::VarRefExprNode>(&varref);
-    //     cursor.skip();
-        
-    //     return AST::make_ref(node);
-    // }
+    return lhs;
+}
 
-    assert(false && "unimplemented");
-}
\ No newline at end of file
+const AST::NodeReference Parser::parse_expr_ref(Parser::Payload &payload, AST::TypeNode *expected_type)
+{
+    return parse_expr_precedence(payload, expected_type, std::numeric_limits<int>::max());
+}
@@ -1,6 +1,8 @@
 #include "Parser/ModuleParser.h"
 
 #include "Parser/ScopeParser.h"
+#include "AST/ASTConstantFolding.h"
+#include "AST/ASTTypeAnnotation.h"
 
 #include <iostream>
 #include <fstream>
@@ -13,12 +15,18 @@ Parser::ModuleParser::ModuleParser()
 }
 
 Parser::Payload Parser::ModuleParser::make_parser_payload(const AST::TokenizedFile &tfile, AST::Module &module, AST::Collector &collector) const 
+{
+    return make_parser_payload(tfile, module, module.nodes, collector);
+}
+
+Parser::Payload Parser::ModuleParser::make_parser_payload(const AST::TokenizedFile &tfile, AST::Module &module, AST::NodeCollection &nodes, AST::Collector &collector) const 
 {
     auto cursor = Cursor(module.tokens, tfile.token_slice.start_index, tfile.token_slice.end_index);
 
     AST::Context context = {
         .module = module,
-        .file = tfile
+        .file = tfile,
+        .nodes = nodes
     };
 
     return Payload {
@@ -30,12 +38,14 @@ Parser::Payload Parser::ModuleParser::make_parser_payload(const AST::TokenizedFi
 
 void Parser::ModuleParser::parse_file_from_disk(std::filesystem::path path, AST::Module &module, AST::Collector &collector) const
 {
-    // create a file entry in the module
-    auto &file = module.add_file(path);
-    file.read_from_disk();
+    // the file only becomes part of the module once it has been read
+    auto read_file = std::make_unique<AST::File>(path);
+    read_file->read_from_disk();
 
     // ensure the content is set
-    assert(file.content.has_value());
+    assert(read_file->has_content());
+
+    auto &file = module.add_file(std::move(read_file));
 
     // parse the file
     auto &tfile = make_tokenized_file(module, file);
@@ -43,6 +53,97 @@ void Parser::ModuleParser::parse_file_from_disk(std::filesystem::path path, AST:
 
     // begin parsing the file root
     file.root = &Parser::parse_scope(payload);   
+    finish_file(file, module.nodes);
+}
+
+void Parser::ModuleParser::parse_files_from_disk(const std::vector<FileEntry> &entries, AST::Bundle &bundle, ThreadPool &pool) const
+{
+    struct Job {
+        AST::Module *module;
+        // owned by the job until it has been read, then handed to the module
+        std::unique_ptr<AST::File> unregistered_file;
+        AST::File *file;
+        // interns into the table of the module right away, the tokens are appended to it later
+        TokenCollection tokens;
+        AST::TokenizedFile *tfile = nullptr;
+        AST::NodeCollection nodes = AST::NodeCollection();
+        AST::Collector collector = AST::Collector();
+        std::exception_ptr error = nullptr;
+
+        Job(AST::Module &module, const std::filesystem::path &path) :
+            module(&module),
+            unregistered_file(std::make_unique<AST::File>(path)),
+            file(unregistered_file.get()),
+            tokens(module.tokens.symbols)
+        {}
+    };
+
+    // heap allocated so the jobs do not move while the workers hold on to them
+    std::vector<std::unique_ptr<Job>> jobs;
+    jobs.reserve(entries.size());
+
+    for (auto &entry : entries) {
+        jobs.push_back(std::make_unique<Job>(bundle.modules.get_module(entry.module), entry.path));
+    }
+
+    auto rethrow_errors = [&jobs]() {
+        for (auto &job : jobs) {
+            if (job->error) {
+                std::rethrow_exception(job->error);
+            }
+        }
+    };
+
+    // read & tokenize every file into its own token collection
+    for (auto &job : jobs) {
+        pool.submit([this, job = job.get()]() {
+            try {
+                job->file->read_from_disk();
+                assert(job->file->has_content());
+
+                AST::OperatorRegistry ops;
+                _lexer->tokenize_prepass_operators(job->file->content(), ops);
+                _lexer->tokenize_view(job->tokens, job->file->content(), &ops);
+            } catch (...) {
+                job->error = std::current_exception();
+            }
+        });
+    }
+
+    pool.wait();
+    rethrow_errors();
+
+    // adding files modifies the module, so the files are registered here once all of them
+    // have been read, a file that failed never ends up in the module.
+    // The parser needs the final token indices of the module, so the 
+    // tokens are merged before parsing, this is just moving some vectors around
+    for (auto &job : jobs) {
+        job->module->add_file(std::move(job->unregistered_file));
+        job->tfile = &job->module->add_tokenized_file(*job->file, std::move(job->tokens));
+    }
+
+    // parse every file into its own node collection, the module 
+    // tokens are no longer modified at this point and only read
+    for (auto &job : jobs) {
+        pool.submit([this, job = job.get()]() {
+            try {
+                auto payload = make_parser_payload(*job->tfile, *job->module, job->nodes, job->collector);
+                job->file->root = &Parser::parse_scope(payload);
+                finish_file(*job->file, job->nodes);
+            } catch (...) {
+                job->error = std::current_exception();
+            }
+        });
+    }
+
+    pool.wait();
+
+    for (auto &job : jobs) {
+        job->module->nodes.merge(std::move(job->nodes));
+        bundle.collector.merge(std::move(job->collector));
+    }
+
+    rethrow_errors();
 }
 
 void Parser::ModuleParser::parse_file_from_mem(std::filesystem::path path, const std::string &content, AST::Module &module, AST::Collector &collector) const
@@ -54,7 +155,7 @@ void Parser::ModuleParser::parse_file_from_mem(std::filesystem::path path, const
     file.set_content(content);
 
     // ensure the content is set
-    assert(file.content.has_value());
+    assert(file.has_content());
 
     // parse the file
     auto &tfile = make_tokenized_file(module, file);
@@ -62,6 +163,19 @@ void Parser::ModuleParser::parse_file_from_mem(std::filesystem::path path, const
 
     // begin parsing the file root
     file.root = &Parser::parse_scope(payload);   
+    finish_file(file, module.nodes);
+}
+
+void Parser::ModuleParser::finish_file(AST::File &file, AST::NodeCollection &nodes) const
+{
+    if (fold_constants) {
+        AST::fold_constants(*file.root, nodes);
+    }
+
+    AST::annotate_types(*file.root);
+    if (lower_compact) {
+        AST::lower_to_compact(*file.root, file.compact);
+    }
 }
 
 AST::TokenizedFile &Parser::ModuleParser::make_tokenized_file(AST::Module &module, AST::File &file) const
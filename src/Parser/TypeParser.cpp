@@ -1,6 +1,8 @@
 #include "Parser/TypeParser.h"
 #include "AST/ASTValueType.h"
 
+#include <array>
+
 
 bool Parser::can_parse_type(Parser::Payload &payload)
 {
@@ -18,41 +20,37 @@ bool Parser::can_parse_type(Parser::Payload &payload)
     return false;
 }
 
-AST::ValueType get_primitive_type(const std::string &types_string)
+// the builtin type names are always the first symbols in the symbol table
+// so resolving them is a simple table lookup
+constexpr std::array<AST::ValueTypePrimitive, Symbol::builtin_count> generate_builtin_type_lut() {
+    std::array<AST::ValueTypePrimitive, Symbol::builtin_count> table = {};
+    table[Symbol::s_int] = AST::ValueTypePrimitive::t_int32;
+    table[Symbol::s_int8] = AST::ValueTypePrimitive::t_int8;
+    table[Symbol::s_int16] = AST::ValueTypePrimitive::t_int16;
+    table[Symbol::s_int32] = AST::ValueTypePrimitive::t_int32;
+    table[Symbol::s_int64] = AST::ValueTypePrimitive::t_int64;
+    table[Symbol::s_uint] = AST::ValueTypePrimitive::t_uint32;
+    table[Symbol::s_uint8] = AST::ValueTypePrimitive::t_uint8;
+    table[Symbol::s_uint16] = AST::ValueTypePrimitive::t_uint16;
+    table[Symbol::s_uint32] = AST::ValueTypePrimitive::t_uint32;
+    table[Symbol::s_uint64] = AST::ValueTypePrimitive::t_uint64;
+    table[Symbol::s_float] = AST::ValueTypePrimitive::t_float32;
+    table[Symbol::s_float32] = AST::ValueTypePrimitive::t_float32;
+    table[Symbol::s_float64] = AST::ValueTypePrimitive::t_float64;
+    table[Symbol::s_bool] = AST::ValueTypePrimitive::t_bool;
+    table[Symbol::s_void] = AST::ValueTypePrimitive::t_void;
+    return table;
+}
+
+constexpr auto builtin_type_lut = generate_builtin_type_lut();
+
+AST::ValueType get_primitive_type(symbol_t symbol)
 {
-    if (types_string == "int") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_int32);
-    } else if (types_string == "int8") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_int8);
-    } else if (types_string == "int16") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_int16);
-    } else if (types_string == "int32") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_int32);
-    } else if (types_string == "int64") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_int64);
-    } else if (types_string == "uint") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_uint32);
-    } else if (types_string == "uint8") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_uint8);
-    } else if (types_string == "uint16") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_uint16);
-    } else if (types_string == "uint32") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_uint32);
-    } else if (types_string == "uint64") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_uint64);
-    } else if (types_string == "float") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_float32);
-    } else if (types_string == "float32") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_float32);
-    } else if (types_string == "float64") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_float64);
-    } else if (types_string == "bool") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_bool);
-    } else if (types_string == "void") {
-        return AST::ValueType(AST::ValueTypePrimitive::t_void);
+    if (symbol >= Symbol::builtin_count) {
+        return AST::ValueType::make_unknown();
     }
 
-    return AST::ValueType::make_unknown();
+    return AST::ValueType(builtin_type_lut[symbol]);
 }
 
 AST::TypeNode &Parser::parse_type(Parser::Payload &payload)
@@ -65,7 +63,7 @@ AST::TypeNode &Parser::parse_type(Parser::Payload &payload)
     }
 
     auto token = payload.cursor.current();
-    auto primitive_type = get_primitive_type(token.value());
+    auto primitive_type = get_primitive_type(token.symbol());
 
     payload.cursor.skip();
 
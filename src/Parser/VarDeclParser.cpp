@@ -52,7 +52,7 @@ AST::VarDeclNode *Parser::parse_vardecl(Parser::Payload &payload, AST::ScopeNode
     // check if the name is already taken in the current scope
     AST::VarDeclNode *prev_vardecl = nullptr;
     if (scope != nullptr) {
-        prev_vardecl = scope->find_vardecl_by_name(nametoken.value());
+        prev_vardecl = scope->find_vardecl_by_symbol(nametoken.symbol());
     }
 
     // we have a previous declaration, this might be a mutable variable
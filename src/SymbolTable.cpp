@@ -0,0 +1,68 @@
+#include "SymbolTable.h"
+
+#include <cassert>
+#include <mutex>
+
+SymbolTable::SymbolTable()
+{
+    for (const auto &name : Symbol::builtin_names) {
+        intern_unlocked(name);
+    }
+
+    assert(_names.size() == Symbol::builtin_count && "Builtin symbols must be unique");
+}
+
+symbol_t SymbolTable::intern_unlocked(std::string_view name)
+{
+    auto found = _lookup.find(name);
+    if (found != _lookup.end()) {
+        return found->second;
+    }
+
+    auto symbol = static_cast<symbol_t>(_names.size());
+    _names.emplace_back(name);
+    _lookup.emplace(_names.back(), symbol);
+
+    return symbol;
+}
+
+symbol_t SymbolTable::intern(std::string_view name)
+{
+    std::unique_lock lock(_mutex);
+    return intern_unlocked(name);
+}
+
+void SymbolTable::intern(const std::vector<std::string_view> &names, std::vector<symbol_t> &symbols)
+{
+    symbols.resize(names.size());
+
+    std::unique_lock lock(_mutex);
+    for (size_t i = 0; i < names.size(); i++) {
+        symbols[i] = intern_unlocked(names[i]);
+    }
+}
+
+symbol_t SymbolTable::find(std::string_view name) const
+{
+    std::shared_lock lock(_mutex);
+
+    auto found = _lookup.find(name);
+    if (found == _lookup.end()) {
+        return no_symbol;
+    }
+
+    return found->second;
+}
+
+std::string_view SymbolTable::name(symbol_t symbol) const
+{
+    std::shared_lock lock(_mutex);
+    assert(symbol < _names.size());
+    return _names[symbol];
+}
+
+size_t SymbolTable::size() const
+{
+    std::shared_lock lock(_mutex);
+    return _names.size();
+}
@@ -0,0 +1,117 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    if (thread_count == 0) {
+        thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        _queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        _threads.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+
+    _work_available.notify_all();
+
+    for (auto &thread : _threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task)
+{
+    {
+        // the counters are updated under the pool mutex so a worker that is about to sleep 
+        // cannot miss the new task, and before the push so a worker can never finish the task
+        // before it has been counted
+        std::lock_guard lock(_mutex);
+        _pending++;
+        _queued++;
+    }
+
+    auto index = _next_queue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+
+    {
+        std::lock_guard lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+
+    _work_available.notify_one();
+}
+
+bool ThreadPool::try_pop(size_t queue_index, Task &task)
+{
+    // our own queue first, newest task first
+    {
+        auto &queue = *_queues[queue_index];
+        std::lock_guard lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            _queued--;
+            return true;
+        }
+    }
+
+    // steal the oldest task from one of the other queues
+    for (size_t i = 1; i < _queues.size(); i++) {
+        auto &queue = *_queues[(queue_index + i) % _queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            _queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t queue_index)
+{
+    Task task;
+
+    while (true) 
+    {
+        if (try_pop(queue_index, task)) {
+            task();
+            task = nullptr;
+
+            if (--_pending == 0) {
+                std::lock_guard lock(_mutex);
+                _work_done.notify_all();
+            }
+
+            continue;
+        }
+
+        std::unique_lock lock(_mutex);
+        _work_available.wait(lock, [this] { 
+            return _stop || _queued > 0; 
+        });
+
+        if (_stop && _queued == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock lock(_mutex);
+    _work_done.wait(lock, [this] { 
+        return _pending == 0; 
+    });
+}
@@ -10,6 +10,27 @@ TokenSlice TokenCollection::slice(size_t start, size_t end) const
     return TokenSlice{*this, start, end};
 }
 
+void TokenCollection::append(TokenCollection &&other)
+{
+    assert(symbols == other.symbols && "Cannot append tokens interned into a different symbol table");
+
+    const auto source_base = static_cast<uint32_t>(sources.size());
+
+    sources.insert(sources.end(), other.sources.begin(), other.sources.end());
+
+    for (auto &owned : other.owned_sources) {
+        owned_sources.push_back(std::move(owned));
+    }
+
+    tokens.reserve(tokens.size() + other.tokens.size());
+    for (auto token : other.tokens) {
+        token.source += source_base;
+        tokens.push_back(token);
+    }
+
+    other.clear();
+}
+
 const TokenReference TokenSlice::start_ref() const
 {
     return TokenReference(tokens, start_index);
@@ -9,11 +9,97 @@
 #include "Parser/ModuleParser.h"
 #include "Compiler/CompilerException.h"
 #include "Compiler/LLVM/LLVMCompiler.h"
+#include "ThreadPool.h"
 
+#include <llvm/Support/Program.h>
 
+
+#include <charconv>
 #include <chrono>
 
-int main() {
+int main(int argc, char *argv[]) {
+
+    auto opt_level = LLVMCompiler::OptLevel::O0;
+    std::string target_cpu;
+    std::string target_features;
+    std::string cache_dir;
+    // when set the program is compiled into an executable instead of being run
+    std::string output_path;
+    bool static_link = false;
+    // hot functions are optimized while the program runs
+    bool tiered = false;
+    uint64_t tier_up_threshold = 0;
+    // generate the code from the compact trees instead of the node tree
+    bool compact = false;
+    // profile guided optimization, instrumented executables write the profile to profile_generate
+    std::string profile_generate;
+    std::string profile_use;
+    std::string linker;
+
+    auto print_usage = [&argv]() {
+        std::cout << "Usage: " << argv[0] << " [-O0|-O1|-O2|-O3|-Os] [--cpu=<name>] [--features=<+feature,-feature>] [--cache-dir=<path>] [-o <executable> [--static]] [--tiered[=<calls>]] [--profile-generate[=<profraw>]|--profile-use=<profdata>] [--linker=<driver>] [--compact]" << std::endl;
+    };
+
+    for (int i = 1; i < argc; i++) {
+        auto arg = std::string_view(argv[i]);
+
+        if (auto level = LLVMCompiler::parse_opt_level(arg)) {
+            opt_level = *level;
+        } else if (arg.starts_with("--cpu=")) {
+            // "native" is the same as leaving it empty
+            target_cpu = arg.substr(6) == "native" ? "" : std::string(arg.substr(6));
+        } else if (arg.starts_with("--features=")) {
+            target_features = std::string(arg.substr(11));
+        } else if (arg.starts_with("--cache-dir=")) {
+            cache_dir = std::string(arg.substr(12));
+        } else if (arg == "-o" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (arg == "--profile-generate") {
+            profile_generate = "default.profraw";
+        } else if (arg.starts_with("--profile-generate=")) {
+            profile_generate = std::string(arg.substr(19));
+        } else if (arg.starts_with("--profile-use=")) {
+            profile_use = std::string(arg.substr(14));
+        } else if (arg.starts_with("--linker=")) {
+            linker = std::string(arg.substr(9));
+        } else if (arg == "--static") {
+            static_link = true;
+        } else if (arg == "--compact") {
+            compact = true;
+        } else if (arg == "--tiered") {
+            tiered = true;
+        } else if (arg.starts_with("--tiered=")) {
+            tiered = true;
+            auto calls = arg.substr(9);
+            auto [end, ec] = std::from_chars(calls.data(), calls.data() + calls.size(), tier_up_threshold);
+            if (ec != std::errc() || end != calls.data() + calls.size()) {
+                std::cout << "Invalid number of calls: " << arg << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else {
+            std::cout << "Unknown option: " << arg << std::endl;
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (!profile_generate.empty() && output_path.empty()) {
+        std::cout << "--profile-generate requires an executable to be linked with -o" << std::endl;
+        return 1;
+    }
+
+    // the instrumented code needs the profile runtime, which only clang links in,
+    // "cc" is usually gcc which does not even know -fprofile-instr-generate
+    if (!profile_generate.empty() && linker.empty()) {
+        linker = "clang";
+    }
+
+    // a missing profile would only be reported once the pipeline runs
+    if (!profile_use.empty() && !std::filesystem::exists(profile_use)) {
+        std::cout << "Profile not found: " << profile_use << std::endl;
+        return 1;
+    }
 
     // mesure performance 
     // start timer
@@ -25,6 +111,7 @@ int main() {
     auto &module = bundle.modules.get_module(module_handle);
 
     auto parser = Parser::ModuleParser();
+    parser.lower_compact = compact;
 
     parser.parse_file_from_disk(std::filesystem::path("test.eco"), module, bundle.collector);
 
@@ -32,10 +119,8 @@ int main() {
     auto end = std::chrono::high_resolution_clock::now();
 
     // dump the tokens
-    auto tokeni = 0;
     for (auto &token : module.tokens.tokens) {
-        auto value = module.tokens.token_values[tokeni];
-        tokeni++;
+        auto value = module.tokens.value(token);
         std::cout << token_type_string(token.type) << " " << value << token.line << ":" << token.char_offset << std::endl;
     }
 
@@ -52,17 +137,58 @@ int main() {
         return 1;
     }
 
+    // the compact trees are all the code generation needs from here on
+    if (compact) {
+        for (auto &ast_module : bundle.modules) {
+            ast_module->release_nodes();
+        }
+    }
+
     // compile the module
     LLVMCompiler compiler;
+    compiler.opt_level = opt_level;
+    compiler.target_cpu = target_cpu;
+    compiler.target_features = target_features;
+    compiler.static_link = static_link;
+    compiler.profile_generate = profile_generate;
+    compiler.profile_use = profile_use;
+    if (!linker.empty()) {
+        compiler.linker = linker;
+    }
+
+    // reported before any code is generated
+    if (!output_path.empty() && !llvm::sys::findProgramByName(compiler.linker)) {
+        std::cout << "Linker not found: " << compiler.linker << std::endl;
+        return 1;
+    }
+    if (tier_up_threshold > 0) {
+        compiler.tier_up_threshold = tier_up_threshold;
+    }
+
+    // compiled objects are reused by later runs of unchanged sources
+    std::unique_ptr<LLVMObjectCache> object_cache;
+    if (!cache_dir.empty()) {
+        object_cache = std::make_unique<LLVMObjectCache>(cache_dir);
+        compiler.object_cache = object_cache.get();
+    }
+
+    ThreadPool pool;
+    int exit_code = 0;
 
     try {
-        compiler.compile_bundle(bundle);
+        if (compact) {
+            compiler.compile_bundle_compact(bundle);
+        } else {
+            compiler.compile_bundle_parallel(bundle, pool);
+        }
 
         compiler.printIR(false);
 
-        compiler.run_code();
-
-        // compiler.make_exec("test");
+        if (output_path.empty()) {
+            exit_code = tiered ? compiler.run_code_tiered() : compiler.run_code();
+        } else if (!compiler.make_exec(output_path, &pool)) {
+            exit_code = 1;
+        }
 
     } catch (Compiler::CompilerException &e) {
         auto issue = &e.issue();
@@ -71,8 +197,8 @@ int main() {
         std::cout << "Issue at " << issue->code_ref.token_slice.startt().line << ":" << issue->code_ref.token_slice.startt().char_offset << std::endl;
         std::cout << issue->message() << std::endl;
         std::cout << issue->code_ref.get_referenced_code_excerpt() << std::endl;
-    
+        exit_code = 1;
     }
     
-    return 0;
+    return exit_code;
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <AST/ASTCompact.h>
+#include <Parser/ModuleParser.h>
+
+TEST_CASE( "Compact Tree Lowering", "[AST]" ) 
+{
+    auto module = AST::Module("test", 0);
+    auto collector = AST::Collector();
+    auto parser = Parser::ModuleParser();
+    parser.lower_compact = true;
+    // lower the expressions as written
+    parser.fold_constants = false;
+
+    parser.parse_file_from_mem("/tmp/compact.eco", "const $foo = 42.1;\nint $bar = 1 + 2;\necho $foo;\necho $bar;", module, collector);
+
+    REQUIRE( collector.issues.size() == 0 );
+
+    auto &file = *module.files().begin();
+    auto &tree = file.compact;
+
+    REQUIRE( AST::cnode_kind(tree.root) == AST::CompactKind::c_scope );
+
+    auto root = tree.scopes.children[AST::cnode_index(tree.root)];
+    REQUIRE( root.count == 4 );
+
+    auto foo = tree.children[root.begin];
+    auto bar = tree.children[root.begin + 1];
+    auto echo_foo = tree.children[root.begin + 2];
+
+    // declarations
+    REQUIRE( AST::cnode_kind(foo) == AST::CompactKind::c_vardecl );
+    REQUIRE( AST::cnode_kind(bar) == AST::CompactKind::c_vardecl );
+    REQUIRE( tree.vardecls.type[AST::cnode_index(foo)] == AST::ValueTypePrimitive::t_float64 );
+    REQUIRE( tree.vardecls.type[AST::cnode_index(bar)] == AST::ValueTypePrimitive::t_int32 );
+    REQUIRE( tree.vardecls.symbol[AST::cnode_index(foo)] == module.tokens.symbols->find("foo") );
+
+    // literals are decoded during lowering
+    auto foo_init = tree.vardecls.init[AST::cnode_index(foo)];
+    REQUIRE( AST::cnode_kind(foo_init) == AST::CompactKind::c_literal_float );
+    REQUIRE( tree.float_literals.value[AST::cnode_index(foo_init)] == 42.1 );
+
+    auto bar_init = tree.vardecls.init[AST::cnode_index(bar)];
+    REQUIRE( AST::cnode_kind(bar_init) == AST::CompactKind::c_binary );
+    REQUIRE( tree.binaries.op[AST::cnode_index(bar_init)] == Token::Type::t_op_add );
+    REQUIRE( tree.result_type(bar_init) == AST::ValueTypePrimitive::t_int32 );
+
+    auto lhs = tree.binaries.lhs[AST::cnode_index(bar_init)];
+    REQUIRE( AST::cnode_kind(lhs) == AST::CompactKind::c_literal_int );
+    REQUIRE( tree.int_literals.value[AST::cnode_index(lhs)] == 1 );
+
+    // echo is a call with its arguments in a contiguous range
+    REQUIRE( AST::cnode_kind(echo_foo) == AST::CompactKind::c_call );
+    auto args = tree.calls.args[AST::cnode_index(echo_foo)];
+    REQUIRE( args.count == 1 );
+
+    auto arg = tree.children[args.begin];
+    REQUIRE( AST::cnode_kind(arg) == AST::CompactKind::c_varref );
+    REQUIRE( tree.varrefs.decl[AST::cnode_index(arg)] == AST::cnode_index(foo) );
+    REQUIRE( tree.result_type(arg) == AST::ValueTypePrimitive::t_float64 );
+
+    REQUIRE( tree.node_count() > 0 );
+}
+
+TEST_CASE( "Compact Tree Handle Overflow", "[AST]" ) 
+{
+    auto node = AST::make_cnode(AST::CompactKind::c_binary, AST::cnode_max_index);
+    REQUIRE( AST::cnode_kind(node) == AST::CompactKind::c_binary );
+    REQUIRE( AST::cnode_index(node) == AST::cnode_max_index );
+
+    // the index must never spill into the kind bits
+    REQUIRE_THROWS_AS( AST::make_cnode(AST::CompactKind::c_binary, AST::cnode_max_index + 1), std::length_error );
+}
+
+TEST_CASE( "Compact Tree outlives the released Nodes", "[AST]" ) 
+{
+    auto module = AST::Module("test", 0);
+    auto collector = AST::Collector();
+    auto parser = Parser::ModuleParser();
+    parser.lower_compact = true;
+
+    parser.parse_file_from_mem("/tmp/compact.eco", "int $bar = 1;\necho $bar;", module, collector);
+    REQUIRE( collector.issues.size() == 0 );
+    REQUIRE( module.nodes.size() > 0 );
+
+    auto &file = *module.files().begin();
+    auto node_count = file.compact.node_count();
+
+    module.release_nodes();
+
+    REQUIRE( file.root == nullptr );
+    REQUIRE( module.nodes.size() == 0 );
+    REQUIRE( module.nodes.bytes_used() == 0 );
+    REQUIRE( file.compact.node_count() == node_count );
+    REQUIRE( file.compact.root != AST::cnode_none );
+}
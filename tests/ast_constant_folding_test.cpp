@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <AST/ASTStaticVisitor.h>
+#include <Parser/ModuleParser.h>
+
+namespace
+{
+    // the root scope of the parsed content
+    AST::ScopeNode &parse_folded(AST::Module &module, const std::string &content)
+    {
+        auto collector = AST::Collector();
+        auto parser = Parser::ModuleParser();
+
+        parser.parse_file_from_mem("/tmp/folding.eco", content, module, collector);
+        REQUIRE( collector.issues.size() == 0 );
+
+        return *(*module.files().begin()).root;
+    }
+
+    std::string init_description(const AST::NodeReference &ref)
+    {
+        return ref.get<AST::VarDeclNode>().init_expr->node_description();
+    }
+}
+
+TEST_CASE( "literal arithmetic is folded in the width of its type", "[AST Folding]" )
+{
+    auto module = AST::Module("test", 0);
+    auto &root = parse_folded(module,
+        "int $a = 2 ** 3 + 4 / 2;\n"
+        "int8 $b = 127 + 1;\n"
+        "uint8 $c = 0 - 1;\n"
+        "uint8 $d = 200 / 3;\n"
+        "int $e = -7 % 3;\n"
+        "float $f = 1.5f * 2.0f;\n"
+        "int $g = 1 / 0;\n"
+    );
+
+    REQUIRE( init_description(root.children[0]) == "literal<int32>(10)" );
+    REQUIRE( init_description(root.children[1]) == "literal<int8>(-128)" );
+    REQUIRE( init_description(root.children[2]) == "literal<uint8>(255)" );
+    REQUIRE( init_description(root.children[3]) == "literal<uint8>(66)" );
+    REQUIRE( init_description(root.children[4]) == "literal<int32>(-1)" );
+    REQUIRE( init_description(root.children[5]) == "literal<float32>(3f)" );
+
+    // dividing by zero is left to the runtime
+    REQUIRE( init_description(root.children[6]) == "binexp<int32>(literal<int32>(1) / literal<int32>(0))" );
+}
+
+TEST_CASE( "const variables are propagated into their uses", "[AST Folding]" )
+{
+    auto module = AST::Module("test", 0);
+    auto &root = parse_folded(module,
+        "const $foo = 42.1;\n"
+        "int $bar = 1;\n"
+        "echo $foo;\n"
+        "echo $bar;\n"
+    );
+
+    auto &echo_foo = root.children[2].get<AST::FunctionCallExprNode>();
+    REQUIRE( echo_foo.arguments[0]->node_description() == "literal<float64>(42.1)" );
+
+    // only const variables, everything else might be assigned again
+    auto &echo_bar = root.children[3].get<AST::FunctionCallExprNode>();
+    REQUIRE( echo_bar.arguments[0]->type_tag() == AST::NodeType::n_expr_varref );
+}
+
+TEST_CASE( "if blocks with a constant condition are pruned", "[AST Folding]" )
+{
+    auto module = AST::Module("test", 0);
+    auto &root = parse_folded(module,
+        "if (2 < 1) { echo 1; }\n"
+        "if (1 > 2) { echo 2; } else if (1 == 1) { echo 3; } else { echo 4; }\n"
+    );
+
+    // the first statement is never entered and is removed entirely
+    REQUIRE( root.children.size() == 1 );
+
+    // the else if is always entered, which makes it the only block left
+    auto &if_stmt = root.children[0].get<AST::IfStatementNode>();
+    REQUIRE( if_stmt.blocks.size() == 1 );
+    REQUIRE( if_stmt.blocks[0].condition == nullptr );
+    REQUIRE( if_stmt.blocks[0].block->children[0].get<AST::FunctionCallExprNode>().arguments[0]->node_description() == "literal<int32>(3)" );
+}
+
+TEST_CASE( "literal comparisons are folded", "[AST Folding]" )
+{
+    auto module = AST::Module("test", 0);
+    auto &root = parse_folded(module,
+        "echo 1 <= 2;\n"
+        "echo 2 <= 2;\n"
+        "echo 3 <= 2;\n"
+        "echo 1 >= 2;\n"
+        "echo 2 >= 2;\n"
+        "echo -1 >= 0;\n"
+        "echo 1.5 <= 1.5;\n"
+        "echo 1.5f >= 2.5f;\n"
+    );
+
+    auto echo_arg = [&root](size_t index) {
+        return root.children[index].get<AST::FunctionCallExprNode>().arguments[0]->node_description();
+    };
+
+    REQUIRE( echo_arg(0) == "literal<bool>(true)" );
+    REQUIRE( echo_arg(1) == "literal<bool>(true)" );
+    REQUIRE( echo_arg(2) == "literal<bool>(false)" );
+    REQUIRE( echo_arg(3) == "literal<bool>(false)" );
+    REQUIRE( echo_arg(4) == "literal<bool>(true)" );
+    // compared as signed integers, like the operands are
+    REQUIRE( echo_arg(5) == "literal<bool>(false)" );
+    REQUIRE( echo_arg(6) == "literal<bool>(true)" );
+    REQUIRE( echo_arg(7) == "literal<bool>(false)" );
+}
@@ -0,0 +1,51 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <AST/ASTFile.h>
+
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE( "File Read From Disk", "[AST]" ) 
+{
+    auto path = std::filesystem::temp_directory_path() / "echo_ast_file_test.eco";
+
+    {
+        auto ostrm = std::ofstream(path, std::ios::binary);
+        ostrm << "<?eco\n$a = 1;\n$b = 2;";
+    }
+
+    auto file = AST::File(path);
+    file.read_from_disk();
+
+    REQUIRE( file.has_content() );
+#if defined(__unix__) || defined(__APPLE__)
+    REQUIRE( file.is_mapped() );
+#endif
+    REQUIRE( file.content() == "\n$a = 1;\n$b = 2;" );
+    REQUIRE( file.get_content_of_line(2) == "$a = 1;" );
+    REQUIRE( file.get_content_of_line(3) == "$b = 2;" );
+    REQUIRE( file.get_content_of_line(4) == "" );
+
+    // content set by hand replaces the mapping
+    file.set_content("$c = 3;");
+
+    REQUIRE( !file.is_mapped() );
+    REQUIRE( file.content() == "$c = 3;" );
+    REQUIRE( file.get_content_of_line(1) == "$c = 3;" );
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE( "File Read Empty From Disk", "[AST]" ) 
+{
+    auto path = std::filesystem::temp_directory_path() / "echo_ast_file_empty_test.eco";
+    std::ofstream(path).close();
+
+    auto file = AST::File(path);
+    file.read_from_disk();
+
+    REQUIRE( file.has_content() );
+    REQUIRE( file.content().empty() );
+
+    std::filesystem::remove(path);
+}
@@ -109,4 +109,46 @@ TEST_CASE( "int value extraction", "[AST Literal]" )
 
     auto &lit0 = tm.nodes.emplace_back<AST::LiteralIntExprNode>(tm.tokens[0]);
 
-}
\ No newline at end of file
+}
+TEST_CASE( "int value decoded into 128 bits", "[AST Literal]" ) 
+{
+    auto tm = EchoTests::tests_make_module_with_content(
+        "9223372036854775807 " // int64 max
+        "-9223372036854775808 " // int64 min
+        "18446744073709551615 " // uint64 max
+        "-170141183460469231731687303715884105728 " // int128 min
+        "170141183460469231731687303715884105728 " // int128 max + 1
+    );
+
+    auto &lit0 = tm.nodes.emplace_back<AST::LiteralIntExprNode>(tm.tokens[0]);
+    REQUIRE(lit0.is_decoded);
+    REQUIRE(lit0.int64_value() == std::numeric_limits<int64_t>::max());
+
+    auto &lit1 = tm.nodes.emplace_back<AST::LiteralIntExprNode>(tm.tokens[1]);
+    REQUIRE(lit1.is_decoded);
+    REQUIRE(lit1.int64_value() == std::numeric_limits<int64_t>::min());
+
+    auto &lit2 = tm.nodes.emplace_back<AST::LiteralIntExprNode>(tm.tokens[2]);
+    REQUIRE(lit2.is_decoded);
+    REQUIRE(lit2.uint64_value() == std::numeric_limits<uint64_t>::max());
+    REQUIRE(lit2.value > std::numeric_limits<int64_t>::max());
+
+    auto &lit3 = tm.nodes.emplace_back<AST::LiteralIntExprNode>(tm.tokens[3]);
+    REQUIRE(lit3.is_decoded);
+    REQUIRE(lit3.value < 0);
+
+    auto &lit4 = tm.nodes.emplace_back<AST::LiteralIntExprNode>(tm.tokens[4]);
+    REQUIRE_FALSE(lit4.is_decoded);
+}
+
+TEST_CASE( "integer size limits", "[AST Literal]" ) 
+{
+    REQUIRE(AST::get_integer_size(AST::ValueTypePrimitive::t_int8).get_max_negative_value() == -128);
+    REQUIRE(AST::get_integer_size(AST::ValueTypePrimitive::t_int8).get_max_positive_value() == 127);
+    REQUIRE(AST::get_integer_size(AST::ValueTypePrimitive::t_uint8).get_max_positive_value() == 255);
+    REQUIRE(AST::get_integer_size(AST::ValueTypePrimitive::t_int32).get_max_negative_value() == std::numeric_limits<int32_t>::min());
+    REQUIRE(AST::get_integer_size(AST::ValueTypePrimitive::t_uint32).get_max_positive_value() == std::numeric_limits<uint32_t>::max());
+    REQUIRE(AST::get_integer_size(AST::ValueTypePrimitive::t_int64).get_max_negative_value() == std::numeric_limits<int64_t>::min());
+    REQUIRE(AST::get_integer_size(AST::ValueTypePrimitive::t_int64).get_max_positive_value() == std::numeric_limits<int64_t>::max());
+    REQUIRE(AST::get_integer_size(AST::ValueTypePrimitive::t_uint64).get_max_positive_value() == std::numeric_limits<uint64_t>::max());
+}
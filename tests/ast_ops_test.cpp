@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include <AST/ASTOps.h>
+#include <Lexer.h>
 #include "helpers.h"
 
 #define TEST_ASSERT_OP_LIT_TYPE(index, lit_type) \
@@ -67,5 +68,15 @@ TEST_CASE( "custom token operators", "[AST Ops]" )
 
     registry.register_custom_op("<=>", 10, AST::OpAssociativity::left);
 
-    
+    Lexer lexer;
+    TokenCollection tokens;
+    lexer.tokenize(tokens, "$a <=> $b", &registry);
+
+    auto op = registry.get_operator(tokens[1]);
+    REQUIRE(op != nullptr);
+    REQUIRE(op == registry.get_operator("<=>"));
+
+    // only tokens lexed as custom operators are looked up by their value
+    REQUIRE(registry.get_operator(tokens[0]) == nullptr);
+    REQUIRE(registry.get_operator(tokens[2]) == nullptr);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <AST/ASTNodeReference.h>
 #include <AST/NullNode.h>
 #include <AST/ScopeNode.h>
+#include <AST/ASTStaticVisitor.h>
 
 TEST_CASE( "Node References", "[AST]" ) 
 {
@@ -48,4 +49,101 @@ TEST_CASE( "Node Reference List", "[AST]" )
 
     REQUIRE( reflist[0].has_type<AST::NullNode>() );
     REQUIRE( !reflist[0].has_type<AST::ScopeNode>() );
-}
\ No newline at end of file
+}
+
+namespace 
+{
+    // counts its destructions, used to verify the node collection cleans up after itself
+    class CountingNode : public AST::Node
+    {
+    public:
+        static constexpr AST::NodeType node_type = AST::NodeType::n_null;
+
+        int &counter;
+        alignas(32) char payload[40] = {};
+
+        CountingNode(int &counter) : counter(counter) {}
+        ~CountingNode() { counter++; }
+
+        const std::string node_description() override {
+            return "Counting";
+        }
+
+        void accept(AST::Visitor &visitor) override {}
+    };
+}
+
+TEST_CASE( "Node Collection Arena", "[AST]" ) 
+{
+    int destroyed = 0;
+
+    {
+        auto nodes = AST::NodeCollection();
+        std::vector<CountingNode *> created;
+
+        // enough nodes to span several arena chunks
+        for (int i = 0; i < 5000; i++) {
+            auto &node = nodes.emplace_back<CountingNode>(destroyed);
+            node.payload[0] = static_cast<char>(i);
+            created.push_back(&node);
+        }
+
+        REQUIRE( nodes.size() == 5000 );
+
+        // addresses stay stable and respect the node alignment
+        for (int i = 0; i < 5000; i++) {
+            REQUIRE( created[i]->payload[0] == static_cast<char>(i) );
+            REQUIRE( reinterpret_cast<uintptr_t>(created[i]) % alignof(CountingNode) == 0 );
+        }
+
+        // merged nodes are owned and destroyed by the target collection
+        auto other = AST::NodeCollection();
+        auto &merged_node = other.emplace_back<CountingNode>(destroyed);
+        merged_node.payload[0] = 42;
+
+        nodes.merge(std::move(other));
+
+        REQUIRE( nodes.size() == 5001 );
+        REQUIRE( other.size() == 0 );
+        REQUIRE( merged_node.payload[0] == 42 );
+
+        // the collection keeps allocating after a merge
+        nodes.emplace_back<AST::NullNode>();
+        REQUIRE( nodes.size() == 5002 );
+        REQUIRE( destroyed == 0 );
+    }
+
+    REQUIRE( destroyed == 5001 );
+}
+
+
+TEST_CASE( "Static Node Visit", "[AST]" ) 
+{
+    auto nodes = AST::NodeCollection();
+    auto &null_node = nodes.emplace_back<AST::NullNode>();
+    auto &scope_node = nodes.emplace_back<AST::ScopeNode>();
+
+    // nodes created by a collection carry their type
+    REQUIRE( null_node.type_tag() == AST::NodeType::n_null );
+    REQUIRE( scope_node.type_tag() == AST::NodeType::n_scope );
+
+    std::string visited;
+    auto describe = [&visited](auto &node) { 
+        visited = node.node_description(); 
+    };
+
+    REQUIRE( AST::visit(static_cast<AST::Node &>(null_node), describe) );
+    REQUIRE( visited == "NULL" );
+
+    REQUIRE( AST::visit(AST::make_ref(scope_node), describe) );
+    REQUIRE( visited == "Scope\n{\n}\n" );
+
+    // nodes outside of a collection are untagged and not dispatched
+    auto stack_node = AST::NullNode();
+    REQUIRE( stack_node.type_tag() == AST::NodeType::n_void );
+    REQUIRE( !AST::visit(static_cast<AST::Node &>(stack_node), describe) );
+
+    // but a reference knows the type regardless
+    REQUIRE( AST::visit(AST::make_ref(stack_node), describe) );
+    REQUIRE( !AST::visit(AST::NodeReference(), describe) );
+}
@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <AST/ASTValueType.h>
+#include <AST/ASTValueTypeCollection.h>
+
+TEST_CASE( "primitive types are fixed handles", "[AST ValueType]" )
+{
+    static_assert(sizeof(AST::ValueType) == sizeof(AST::vt_handle_t));
+    static_assert(std::is_trivially_copyable_v<AST::ValueType>);
+
+    auto int32 = AST::ValueType(AST::ValueTypePrimitive::t_int32);
+
+    REQUIRE(int32 == AST::ValueType(AST::ValueTypePrimitive::t_int32));
+    REQUIRE(int32 != AST::ValueType(AST::ValueTypePrimitive::t_int64));
+    REQUIRE(int32.is_primitive());
+    REQUIRE(int32.is_signed_integer());
+    REQUIRE(int32.get_type_desciption() == "int32");
+
+    REQUIRE(AST::ValueType() == AST::ValueType::make_void());
+    REQUIRE(AST::ValueType::make_void().is_primitive());
+
+    auto unknown = AST::ValueType::make_unknown();
+    REQUIRE_FALSE(unknown.is_primitive());
+    REQUIRE(unknown.is_unknown());
+    REQUIRE(unknown != AST::ValueType::make_void());
+    REQUIRE(unknown.get_primitive_type() == AST::ValueTypePrimitive::t_void);
+}
+
+TEST_CASE( "interned types are hash consed", "[AST ValueType]" )
+{
+    auto types = AST::ValueTypeCollection();
+
+    auto int32 = AST::ValueType(AST::ValueTypePrimitive::t_int32);
+    auto float64 = AST::ValueType(AST::ValueTypePrimitive::t_float64);
+
+    auto point = types.intern({ AST::ValueTypeKind::t_struct, "Point", { { "y", float64 }, { "x", float64 } } });
+    auto same_point = types.intern({ AST::ValueTypeKind::t_struct, "Point", { { "x", float64 }, { "y", float64 } } });
+    auto other = types.intern({ AST::ValueTypeKind::t_struct, std::nullopt, { { "x", int32 }, { "p", point } } });
+
+    REQUIRE(point == same_point);
+    REQUIRE(point != other);
+    REQUIRE(types.size() == 2);
+
+    REQUIRE(point.is_interned());
+    REQUIRE_FALSE(point.is_primitive());
+    REQUIRE(point.get_primitive_type() == AST::ValueTypePrimitive::t_complex);
+    REQUIRE(types.kind(point) == AST::ValueTypeKind::t_struct);
+    REQUIRE(types.kind(int32) == AST::ValueTypeKind::t_primitive);
+
+    REQUIRE(types.descriptor(point).properties[0].first == "x");
+    REQUIRE(types.get_type_description(point) == "Point");
+    REQUIRE(types.get_type_description(other) == "{Point, int32}");
+}
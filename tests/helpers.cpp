@@ -1,5 +1,7 @@
 #include "helpers.h"
 
+#include <unistd.h>
+
 EchoTests::ParserEnv EchoTests::tests_make_parser_env(std::string content)
 {
     auto echomod = std::make_unique<AST::Module>("test", 0);
@@ -41,3 +43,39 @@ AST::Module EchoTests::tests_make_module_with_content(std::string content)
 
     return module;
 }
+
+EchoTests::StdoutCapture::StdoutCapture()
+{
+    std::fflush(stdout);
+    saved_fd = dup(STDOUT_FILENO);
+    dup2(fileno(file), STDOUT_FILENO);
+}
+
+EchoTests::StdoutCapture::~StdoutCapture()
+{
+    restore();
+    std::fclose(file);
+}
+
+void EchoTests::StdoutCapture::restore()
+{
+    if (saved_fd >= 0) {
+        std::fflush(stdout);
+        dup2(saved_fd, STDOUT_FILENO);
+        close(saved_fd);
+        saved_fd = -1;
+    }
+}
+
+std::string EchoTests::StdoutCapture::written()
+{
+    std::fflush(stdout);
+    std::string content;
+    std::rewind(file);
+    char chunk[4096];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        content.append(chunk, read);
+    }
+    return content;
+}
@@ -1,7 +1,9 @@
 #include <Parser/ParserCursor.h>
 #include <Parser/ModuleParser.h>
 
+#include <cstdio>
 #include <memory>
+#include <string>
 
 namespace EchoTests
 {
@@ -16,6 +18,21 @@ namespace EchoTests
     ParserEnv tests_make_parser_env(std::string content);
     
     AST::Module tests_make_module_with_content(std::string content);
+
+    // stdout goes into a temporary file while the capture is alive
+    struct StdoutCapture
+    {
+        FILE *file = std::tmpfile();
+        int saved_fd = -1;
+
+        StdoutCapture();
+        ~StdoutCapture();
+
+        void restore();
+
+        // everything that reached stdout so far, not what is still in the buffer of the runtime
+        std::string written();
+    };
 }
 
 
@@ -124,7 +124,7 @@ TEST_CASE( "Strings", "[lexer]" ) {
     REQUIRE( tokens.tokens[2].type == Token::Type::t_string_literal );
 
     // check the values
-    REQUIRE( tokens.token_values[0] == "'foo'" );
+    REQUIRE( tokens[0].value() == "'foo'" );
 
     tokens.clear();
 
@@ -136,35 +136,35 @@ TEST_CASE( "Strings", "[lexer]" ) {
     REQUIRE( tokens.tokens[2].type == Token::Type::t_string_literal );
 
     // check the values
-    REQUIRE( tokens.token_values[0] == "\"foo\"" );
+    REQUIRE( tokens[0].value() == "\"foo\"" );
 
     // test empty string
     tokens.clear();
     lexer.tokenize(tokens, "''");
 
     REQUIRE( tokens.tokens[0].type == Token::Type::t_string_literal );
-    REQUIRE( tokens.token_values[0] == "''" );
+    REQUIRE( tokens[0].value() == "''" );
 
     // test string with escaped quotes
     tokens.clear();
     lexer.tokenize(tokens, "'\\'foo\\''");
 
     REQUIRE( tokens.tokens[0].type == Token::Type::t_string_literal );
-    REQUIRE( tokens.token_values[0] == "'\\'foo\\''" );
+    REQUIRE( tokens[0].value() == "'\\'foo\\''" );
 
     // test line breaks
     tokens.clear();
     lexer.tokenize(tokens, "'foo\nbar'");
 
     REQUIRE( tokens.tokens[0].type == Token::Type::t_string_literal );
-    REQUIRE( tokens.token_values[0] == "'foo\nbar'" );
+    REQUIRE( tokens[0].value() == "'foo\nbar'" );
 
     // test utf-8
     tokens.clear();
     lexer.tokenize(tokens, "'🍕'");
 
     REQUIRE( tokens.tokens[0].type == Token::Type::t_string_literal );
-    REQUIRE( tokens.token_values[0] == "'🍕'" );
+    REQUIRE( tokens[0].value() == "'🍕'" );
 }
 
 TEST_CASE( "Unterminated String", "[lexer]" ) {
@@ -186,8 +186,8 @@ TEST_CASE( "Variable Names", "[lexer]" )
     REQUIRE( tokens.tokens[2].type == Token::Type::t_varname );
 
     // check the values
-    REQUIRE( tokens.token_values[0] == "$foo" );
-    REQUIRE( tokens.token_values[2] == "$bar" );
+    REQUIRE( tokens[0].value() == "$foo" );
+    REQUIRE( tokens[2].value() == "$bar" );
 }
 
 TEST_CASE( "Variable Names Incomplete", "[lexer]" ) 
@@ -201,8 +201,8 @@ TEST_CASE( "Variable Names Incomplete", "[lexer]" )
     REQUIRE( tokens.tokens[1].type == Token::Type::t_varname );
 
     // check the values
-    REQUIRE( tokens.token_values[0] == "$" );
-    REQUIRE( tokens.token_values[1] == "$bar" );
+    REQUIRE( tokens[0].value() == "$" );
+    REQUIRE( tokens[1].value() == "$bar" );
 }
 
 
@@ -218,20 +218,20 @@ TEST_CASE( "HexLiterals", "[lexer]" ) {
     REQUIRE( tokens.tokens[2].type == Token::Type::t_hex_literal );
 
     // check the values
-    REQUIRE( tokens.token_values[0] == "0x0" );
-    REQUIRE( tokens.token_values[2] == "0x1" );
+    REQUIRE( tokens[0].value() == "0x0" );
+    REQUIRE( tokens[2].value() == "0x1" );
 
     // check long hex literals
     tokens.clear();
     lexer.tokenize(tokens, "0x1234567890abcdef");
     REQUIRE( tokens.tokens[0].type == Token::Type::t_hex_literal );
-    REQUIRE( tokens.token_values[0] == "0x1234567890abcdef" );
+    REQUIRE( tokens[0].value() == "0x1234567890abcdef" );
 
     // check uppercase hex literals
     tokens.clear();
     lexer.tokenize(tokens, "0x1234567890ABCDEF");
     REQUIRE( tokens.tokens[0].type == Token::Type::t_hex_literal );
-    REQUIRE( tokens.token_values[0] == "0x1234567890ABCDEF" );
+    REQUIRE( tokens[0].value() == "0x1234567890ABCDEF" );
 }
 
 TEST_CASE( "Single Line Comments", "[lexer]" ) {
@@ -244,7 +244,7 @@ TEST_CASE( "Single Line Comments", "[lexer]" ) {
     REQUIRE( tokens.tokens[0].type == Token::Type::t_identifier );
 
     // check the values
-    REQUIRE( tokens.token_values[0] == "foo" );
+    REQUIRE( tokens[0].value() == "foo" );
 }
 
 TEST_CASE("Multi Line Comments", "[lexer]") {
@@ -258,8 +258,8 @@ TEST_CASE("Multi Line Comments", "[lexer]") {
     REQUIRE( tokens.tokens[1].type == Token::Type::t_identifier );
 
     // check the values
-    REQUIRE( tokens.token_values[0] == "hey" );
-    REQUIRE( tokens.token_values[1] == "ronon" );
+    REQUIRE( tokens[0].value() == "hey" );
+    REQUIRE( tokens[1].value() == "ronon" );
 }
 
 TEST_CASE("Multi Line Comments Unterminated", "[lexer]") {
@@ -344,5 +344,146 @@ TEST_CASE( "Operator Prepass", "[lexer]" ) {
     REQUIRE( tokens.tokens[21].type == Token::Type::t_op_custom );
     REQUIRE( tokens.tokens[22].type == Token::Type::t_integer_literal );
 
-    REQUIRE( tokens.token_values[21] == "<=>" );
-}
\ No newline at end of file
+    REQUIRE( tokens[21].value() == "<=>" );
+}
+// the built-in dispatch tree is shared between calls, custom operators
+// of one input must never leak into the next one
+TEST_CASE( "Lexer Reuse", "[lexer]" ) {
+    Lexer lexer;
+    AST::OperatorRegistry ops;
+    ops.register_custom_op("<=>", -1, AST::OpAssociativity::left);
+
+    TokenCollection tokens;
+    lexer.tokenize(tokens, "42 <=> 69", &ops);
+
+    REQUIRE( tokens.tokens.size() == 3 );
+    REQUIRE( tokens.tokens[1].type == Token::Type::t_op_custom );
+    REQUIRE( tokens[1].value() == "<=>" );
+
+    tokens.clear();
+    lexer.tokenize(tokens, "42 <=> 69");
+
+    REQUIRE( tokens.tokens.size() == 4 );
+    REQUIRE( tokens.tokens[1].type == Token::Type::t_logical_leq );
+    REQUIRE( tokens.tokens[2].type == Token::Type::t_close_angle );
+
+    // custom operators are only considered when they are the longer match
+    tokens.clear();
+    lexer.tokenize(tokens, "$a <= $b <=> $c", &ops);
+
+    REQUIRE( tokens.tokens.size() == 5 );
+    REQUIRE( tokens.tokens[1].type == Token::Type::t_logical_leq );
+    REQUIRE( tokens.tokens[3].type == Token::Type::t_op_custom );
+}
+
+TEST_CASE( "Lexer Table matches Function Tree", "[lexer]" ) {
+    Lexer lexer;
+
+    const std::string input = 
+        "function add(int $a, float $b) : float {\n"
+        "    // comment\n"
+        "    const $c = 0xFF + -42 * 3.14f / 2. % $a;\n"
+        "    /* multi\n line */\n"
+        "    if ($a <= $b && $b != 1 || !true) { echo \"hello\", 'world'; }\n"
+        "    else { return $a ** 2 << 1 >> 2 ^ $b++ - --$c; }\n"
+        "}\n";
+
+    TokenCollection tree_tokens;
+    LexerCursor tree_cursor(input, tree_tokens.add_source(input));
+    lexer.execute_functions(nullptr, tree_tokens, tree_cursor);
+
+    TokenCollection table_tokens;
+    LexerCursor table_cursor(input, table_tokens.add_source(input));
+    lexer.execute_table(nullptr, table_tokens, table_cursor);
+
+    REQUIRE( tree_tokens.tokens.size() == table_tokens.tokens.size() );
+
+    for (size_t i = 0; i < tree_tokens.tokens.size(); i++) {
+        REQUIRE( tree_tokens.tokens[i].type == table_tokens.tokens[i].type );
+        REQUIRE( tree_tokens.tokens[i].line == table_tokens.tokens[i].line );
+        REQUIRE( tree_tokens.tokens[i].char_offset == table_tokens.tokens[i].char_offset );
+        REQUIRE( tree_tokens[i].value() == table_tokens[i].value() );
+    }
+}
+
+TEST_CASE( "Long Runs Line Tracking", "[lexer]" ) {
+    Lexer lexer;
+    TokenCollection tokens;
+
+    // the runs are longer than a scanning block so the bulk line / column updates are used
+    const std::string input = 
+        "$a" + std::string(40, ' ') + "\n\n   " + 
+        "$" + std::string(50, 'x') + " \"" + std::string(40, 's') + "\n" + std::string(20, 't') + "\"" +
+        " /*" + std::string(40, 'c') + "\n\n*/ foo";
+
+    lexer.tokenize(tokens, input);
+
+    REQUIRE( tokens.tokens.size() == 4 );
+
+    REQUIRE( tokens.tokens[0].type == Token::Type::t_varname );
+    REQUIRE( tokens.tokens[0].line == 1 );
+    REQUIRE( tokens.tokens[0].char_offset == 1 );
+
+    REQUIRE( tokens.tokens[1].type == Token::Type::t_varname );
+    REQUIRE( tokens[1].value() == "$" + std::string(50, 'x') );
+    REQUIRE( tokens.tokens[1].line == 3 );
+    REQUIRE( tokens.tokens[1].char_offset == 4 );
+
+    REQUIRE( tokens.tokens[2].type == Token::Type::t_string_literal );
+    REQUIRE( tokens[2].value() == "\"" + std::string(40, 's') + "\n" + std::string(20, 't') + "\"" );
+    REQUIRE( tokens.tokens[2].line == 3 );
+    REQUIRE( tokens.tokens[2].char_offset == 56 );
+
+    REQUIRE( tokens.tokens[3].type == Token::Type::t_identifier );
+    REQUIRE( tokens[3].value() == "foo" );
+    REQUIRE( tokens.tokens[3].line == 6 );
+    REQUIRE( tokens.tokens[3].char_offset == 4 );
+}
+
+TEST_CASE( "Token Values Reference Source", "[lexer]" ) {
+    Lexer lexer;
+    TokenCollection tokens;
+
+    const std::string input = "$foo = bar(0xFF, 0XAB, 1.5f, 2., \"baz\");";
+    lexer.tokenize_view(tokens, input);
+
+    REQUIRE( tokens.sources.size() == 3 );
+    REQUIRE( tokens.owned_sources.size() == 2 );
+
+    // values that exist in the source point directly into it
+    REQUIRE( tokens[0].value() == "$foo" );
+    REQUIRE( tokens[0].value().data() == input.data() );
+    REQUIRE( tokens[2].value().data() == input.data() + 7 );
+    REQUIRE( tokens[4].value() == "0xFF" );
+    REQUIRE( tokens[8].value() == "1.5f" );
+    REQUIRE( tokens[12].value() == "\"baz\"" );
+
+    // only normalized values get their own storage
+    REQUIRE( tokens[6].value() == "0xAB" );
+    REQUIRE( tokens[10].value() == "2.0" );
+}
+
+TEST_CASE( "Identifier Symbols", "[lexer]" ) {
+    Lexer lexer;
+    TokenCollection tokens;
+
+    lexer.tokenize(tokens, "int $foo = bar($foo, foo, float);");
+
+    // builtin type names always resolve to their fixed symbol
+    REQUIRE( tokens[0].symbol() == Symbol::s_int );
+    REQUIRE( tokens[9].symbol() == Symbol::s_float );
+
+    // variable names are interned without the "$" prefix
+    REQUIRE( tokens[1].symbol() != no_symbol );
+    REQUIRE( tokens[1].symbol() == tokens[5].symbol() );
+    REQUIRE( tokens[1].symbol() == tokens[7].symbol() );
+    REQUIRE( tokens.symbols->name(tokens[1].symbol()) == "foo" );
+
+    REQUIRE( tokens[3].symbol() != tokens[1].symbol() );
+    REQUIRE( tokens.symbols->name(tokens[3].symbol()) == "bar" );
+    REQUIRE( tokens.symbols->find("bar") == tokens[3].symbol() );
+    REQUIRE( tokens.symbols->find("baz") == no_symbol );
+
+    // other tokens carry no symbol
+    REQUIRE( tokens[2].symbol() == no_symbol );
+}
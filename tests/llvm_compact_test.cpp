@@ -0,0 +1,18 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <Compiler/LLVM/LLVMCompiler.h>
+#include <Parser/ModuleParser.h>
+
+TEST_CASE( "Compact Compilation requires lowered Files", "[LLVM]" ) 
+{
+    auto bundle = AST::Bundle();
+    auto &module = bundle.modules.get_module(bundle.modules.add_module("main"));
+
+    // not lowered, the file only has its node tree
+    auto parser = Parser::ModuleParser();
+    parser.parse_file_from_mem("/tmp/compact.eco", "echo 1;", module, bundle.collector);
+    REQUIRE( bundle.collector.issues.size() == 0 );
+
+    LLVMCompiler compiler;
+    REQUIRE_THROWS_AS( compiler.compile_bundle_compact(bundle), std::runtime_error );
+}
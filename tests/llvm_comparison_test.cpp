@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <Compiler/LLVM/LLVMCompiler.h>
+#include <Parser/ModuleParser.h>
+
+#include "helpers.h"
+
+#include <string>
+
+namespace
+{
+    // compiles and runs the code in the JIT, returns what the program printed
+    std::string run_output(const std::string &code)
+    {
+        auto bundle = AST::Bundle();
+        auto &module = bundle.modules.get_module(bundle.modules.add_module("main"));
+
+        auto parser = Parser::ModuleParser();
+        parser.parse_file_from_mem("/tmp/comparison.eco", code, module, bundle.collector);
+        REQUIRE( bundle.collector.issues.size() == 0 );
+
+        LLVMCompiler compiler;
+        compiler.compile_bundle(bundle);
+
+        // anything the compiler still buffers would end up in the capture otherwise
+        llvm::outs().flush();
+
+        EchoTests::StdoutCapture capture;
+        REQUIRE( compiler.run_code() == 0 );
+        return capture.written();
+    }
+}
+
+// variables are not folded, so these go through the code generation
+TEST_CASE( "Comparisons of Variables are compiled", "[LLVM]" ) 
+{
+    SECTION("signed integers") {
+        auto output = run_output(R"(
+            int $a = 1;
+            int $b = 2;
+            int $n = 0 - 1;
+            echo $a <= $b;
+            echo $b <= $a;
+            echo $a >= $a;
+            echo $a >= $b;
+            echo $n >= $a;
+            echo $n < $a;
+        )");
+        REQUIRE( output.starts_with("1\n0\n1\n0\n0\n1\n") );
+    }
+
+    SECTION("unsigned integers") {
+        auto output = run_output(R"(
+            uint $u = 0 - 1;
+            uint $v = 1;
+            echo $u >= $v;
+            echo $v <= $u;
+            echo $u > $v;
+            echo $u < $v;
+        )");
+        REQUIRE( output.starts_with("1\n1\n1\n0\n") );
+    }
+
+    SECTION("floats") {
+        auto output = run_output(R"(
+            float64 $x = 0.5;
+            echo $x < 1.5;
+            echo $x > 1.5;
+            echo $x >= 1.5;
+            echo $x <= 0.5;
+            echo $x == 0.5;
+            echo $x != 0.5;
+        )");
+        REQUIRE( output.starts_with("1\n0\n0\n1\n1\n0\n") );
+    }
+}
@@ -0,0 +1,24 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <Compiler/LLVM/LLVMCompiler.h>
+#include <Parser/ModuleParser.h>
+
+TEST_CASE( "Object Cache Key follows the Build Id", "[LLVM]" ) 
+{
+    auto bundle = AST::Bundle();
+    auto &module = bundle.modules.get_module(bundle.modules.add_module("main"));
+
+    auto parser = Parser::ModuleParser();
+    parser.parse_file_from_mem("/tmp/cache.eco", "int $a = 42;\necho $a;", module, bundle.collector);
+    REQUIRE( bundle.collector.issues.size() == 0 );
+
+    LLVMCompiler compiler;
+    REQUIRE( !compiler.build_id.empty() );
+
+    auto key = compiler.object_cache_key(bundle, "serial");
+    REQUIRE( key == compiler.object_cache_key(bundle, "serial") );
+
+    // objects of another compiler build must never be loaded
+    compiler.build_id += "-rebuilt";
+    REQUIRE( compiler.object_cache_key(bundle, "serial") != key );
+}
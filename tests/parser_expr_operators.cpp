@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <AST/ASTNodeReference.h>
+#include <AST/ExprNode.h>
+#include <AST/ASTTypeAnnotation.h>
+#include <Parser/ExprParser.h>
+
+#include "helpers.h"
+
+TEST_CASE( "binary operator precedence", "[Parser Expr]" )
+{
+    auto env = EchoTests::tests_make_parser_env(
+        "1 + 2 * 3"
+    );
+
+    auto expr = Parser::parse_expr(env.payload);
+
+    REQUIRE(env.collector->issues.size() == 0);
+    REQUIRE(expr->node_description() == "binexp<int32>(literal<int32>(1) + binexp<int32>(literal<int32>(2) * literal<int32>(3)))");
+    REQUIRE(env.payload.cursor.is_done());
+}
+
+TEST_CASE( "left associative operators chain to the left", "[Parser Expr]" )
+{
+    auto env = EchoTests::tests_make_parser_env(
+        "8 - 4 - 2"
+    );
+
+    auto expr = Parser::parse_expr(env.payload);
+
+    REQUIRE(env.collector->issues.size() == 0);
+    REQUIRE(expr->node_description() == "binexp<int32>(binexp<int32>(literal<int32>(8) - literal<int32>(4)) - literal<int32>(2))");
+}
+
+TEST_CASE( "parentheses group without a node", "[Parser Expr]" )
+{
+    auto env = EchoTests::tests_make_parser_env(
+        "(1 + 2) * 3"
+    );
+
+    auto expr = Parser::parse_expr(env.payload);
+
+    REQUIRE(env.collector->issues.size() == 0);
+    REQUIRE(expr->node_description() == "binexp<int32>(binexp<int32>(literal<int32>(1) + literal<int32>(2)) * literal<int32>(3))");
+}
+
+TEST_CASE( "expression ends at a closing parenthesis", "[Parser Expr]" )
+{
+    auto env = EchoTests::tests_make_parser_env(
+        "1 < 2) {"
+    );
+
+    auto expr = Parser::parse_expr(env.payload);
+
+    REQUIRE(env.collector->issues.size() == 0);
+    REQUIRE(expr->node_description() == "binexp<int32>(literal<int32>(1) < literal<int32>(2))");
+    REQUIRE(env.payload.cursor.is_type(Token::Type::t_close_paren));
+}
+
+TEST_CASE( "prefix and postfix operators", "[Parser Expr]" )
+{
+    auto env = EchoTests::tests_make_parser_env(
+        "-(1 + 2) * 3"
+    );
+
+    auto expr = Parser::parse_expr(env.payload);
+
+    REQUIRE(env.collector->issues.size() == 0);
+    REQUIRE(expr->node_description() == "binexp<int32>(unexp(-binexp<int32>(literal<int32>(1) + literal<int32>(2))) * literal<int32>(3))");
+
+    auto postfix_env = EchoTests::tests_make_parser_env(
+        "2 ++ * 3"
+    );
+
+    auto postfix = Parser::parse_expr(postfix_env.payload);
+
+    // increment and decrement are parsed but cannot be compiled yet
+    REQUIRE(postfix_env.collector->issues.size() == 1);
+    REQUIRE(postfix_env.collector->issues[0]->is_critical());
+    REQUIRE(postfix->node_description() == "binexp<int32>(unexp(literal<int32>(2)++) * literal<int32>(3))");
+
+    auto prefix_env = EchoTests::tests_make_parser_env(
+        "--2 + 3"
+    );
+
+    auto prefix = Parser::parse_expr(prefix_env.payload);
+
+    REQUIRE(prefix_env.collector->issues.size() == 1);
+    REQUIRE(prefix->node_description() == "binexp<int32>(unexp(--literal<int32>(2)) + literal<int32>(3))");
+}
+
+TEST_CASE( "only the nodes of the tree are stored", "[Parser Expr]" )
+{
+    auto env = EchoTests::tests_make_parser_env(
+        "1 + 2 + 3"
+    );
+
+    auto expr = Parser::parse_expr(env.payload);
+
+    REQUIRE(expr != nullptr);
+    // 3 literals, 2 operators and 2 binary expressions
+    REQUIRE(env.module->nodes.size() == 7);
+}
+
+TEST_CASE( "expression types are annotated once", "[Parser Expr]" )
+{
+    auto env = EchoTests::tests_make_parser_env(
+        "(1 + 2) * 3"
+    );
+
+    auto expr = Parser::parse_expr(env.payload);
+    REQUIRE_FALSE(expr->annotated_type.has_value());
+
+    AST::annotate_types(*expr);
+
+    auto &binary = static_cast<AST::BinaryExprNode &>(*expr);
+    REQUIRE(binary.annotated_type == AST::ValueType(AST::ValueTypePrimitive::t_int32));
+    REQUIRE(binary.lhs->annotated_type == AST::ValueType(AST::ValueTypePrimitive::t_int32));
+    REQUIRE(binary.rhs->annotated_type == AST::ValueType(AST::ValueTypePrimitive::t_int32));
+
+    // the stored type is what the expression reports from now on
+    binary.annotated_type = AST::ValueType(AST::ValueTypePrimitive::t_int64);
+    REQUIRE(binary.result_type() == AST::ValueType(AST::ValueTypePrimitive::t_int64));
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <AST/ASTBundle.h>
+#include <Parser/ModuleParser.h>
+#include <ThreadPool.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+TEST_CASE( "Thread Pool Runs All Tasks", "[parser]" ) 
+{
+    ThreadPool pool(4);
+    REQUIRE( pool.size() == 4 );
+
+    std::atomic<int> counter = 0;
+
+    // run twice to make sure the pool can be reused after waiting
+    for (int round = 1; round <= 2; round++) {
+        for (int i = 0; i < 1000; i++) {
+            pool.submit([&counter]() { counter++; });
+        }
+
+        pool.wait();
+        REQUIRE( counter == 1000 * round );
+    }
+}
+
+TEST_CASE( "Parse Files In Parallel", "[parser]" ) 
+{
+    const size_t file_count = 8;
+
+    std::vector<Parser::ModuleParser::FileEntry> entries;
+
+    auto bundle = AST::Bundle();
+    auto main_handle = bundle.modules.add_module("main");
+    auto other_handle = bundle.modules.add_module("other");
+
+    for (size_t i = 0; i < file_count; i++) {
+        auto path = std::filesystem::temp_directory_path() / ("echo_parallel_test_" + std::to_string(i) + ".eco");
+
+        {
+            auto ostrm = std::ofstream(path, std::ios::binary);
+            ostrm << "<?eco\nconst $foo" << i << " = 42.1;\n\necho $foo" << i << ";";
+        }
+
+        entries.push_back({ i % 2 ? other_handle : main_handle, path });
+    }
+
+    ThreadPool pool(4);
+    auto parser = Parser::ModuleParser();
+    parser.parse_files_from_disk(entries, bundle, pool);
+
+    // parse the same files serially to compare against
+    auto serial_bundle = AST::Bundle();
+    auto &serial_module = serial_bundle.modules.get_module(serial_bundle.modules.add_module("main"));
+    for (auto &entry : entries) {
+        parser.parse_file_from_disk(entry.path, serial_module, serial_bundle.collector);
+    }
+
+    auto &main_module = bundle.modules.get_module(main_handle);
+    auto &other_module = bundle.modules.get_module(other_handle);
+
+    REQUIRE( main_module.tokens.size() + other_module.tokens.size() == serial_module.tokens.size() );
+    REQUIRE( main_module.nodes.size() + other_module.nodes.size() == serial_module.nodes.size() );
+    REQUIRE( bundle.collector.issues.size() == serial_bundle.collector.issues.size() );
+
+    // files keep the order they have been passed in
+    size_t index = 0;
+    for (auto &file : main_module.files()) {
+        REQUIRE( file.get_path() == entries[index].path );
+        REQUIRE( file.root != nullptr );
+        index += 2;
+    }
+
+    // tokens of the merged files reference the right source
+    REQUIRE( main_module.tokens[1].value() == "$foo0" );
+    REQUIRE( other_module.tokens[1].value() == "$foo1" );
+    REQUIRE( main_module.tokens[1].symbol() != other_module.tokens[1].symbol() );
+
+    for (auto &entry : entries) {
+        std::filesystem::remove(entry.path);
+    }
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <EchoRuntime.h>
+
+#include "helpers.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+namespace
+{
+    // the exact bytes the given echo calls produce once the program exits
+    std::string echo_output(const std::function<void()> &calls)
+    {
+        EchoTests::StdoutCapture capture;
+        calls();
+        echo_runtime_exit();
+        auto output = capture.written();
+        capture.restore();
+        return output;
+    }
+}
+
+TEST_CASE( "Runtime formats Integers", "[runtime]" ) 
+{
+    REQUIRE( echo_output([]() {
+        echo_u64(0);
+        echo_u64(9);
+        echo_u64(10);
+        echo_u64(99);
+        echo_u64(100);
+        echo_u64(101);
+        echo_u64(1000);
+        echo_u64(12345);
+        echo_u64(1234567890123);
+    }) == "0\n9\n10\n99\n100\n101\n1000\n12345\n1234567890123\n" );
+
+    REQUIRE( echo_output([]() {
+        echo_i32(0);
+        echo_i32(-7);
+        echo_i32(INT32_MIN);
+        echo_i32(INT32_MAX);
+        echo_u32(UINT32_MAX);
+    }) == "0\n-7\n-2147483648\n2147483647\n4294967295\n" );
+
+    // the smallest value has no positive counterpart in the signed type
+    REQUIRE( echo_output([]() {
+        echo_i64(INT64_MIN);
+        echo_i64(INT64_MAX);
+        echo_u64(UINT64_MAX);
+    }) == "-9223372036854775808\n9223372036854775807\n18446744073709551615\n" );
+}
+
+TEST_CASE( "Runtime formats Floats and Strings", "[runtime]" ) 
+{
+    REQUIRE( echo_output([]() {
+        echo_f64(1.5);
+        echo_f64(-0.25);
+        echo_str("");
+        echo_str("hello");
+    }) == "1.500000\n-0.250000\n\nhello\n" );
+}
+
+TEST_CASE( "Runtime flushes a full Buffer", "[runtime]" ) 
+{
+    // 511 characters and the newline, the longest line that is still buffered
+    auto line = std::string(511, 'x');
+
+    EchoTests::StdoutCapture capture;
+
+    // 128 of them fill the 64KB buffer exactly
+    for (int i = 0; i < 128; i++) {
+        echo_str(line.c_str());
+    }
+    REQUIRE( capture.written().empty() );
+
+    // the next line does not fit anymore, everything before it is written out
+    echo_i32(7);
+    REQUIRE( capture.written().size() == 128 * 512 );
+
+    echo_runtime_exit();
+
+    auto expected = std::string();
+    for (int i = 0; i < 128; i++) {
+        expected += line + "\n";
+    }
+    expected += "7\n";
+    REQUIRE( capture.written() == expected );
+}
+
+TEST_CASE( "Runtime writes long Strings directly", "[runtime]" ) 
+{
+    auto longest_buffered = std::string(511, 'a');
+    auto direct = std::string(512, 'b');
+    auto huge = std::string(100 * 1024, 'c');
+
+    // the output before a direct write goes out first, so the order stays intact
+    REQUIRE( echo_output([&]() {
+        echo_i32(1);
+        echo_str(longest_buffered.c_str());
+        echo_str(direct.c_str());
+        echo_i32(2);
+        echo_str(huge.c_str());
+        echo_i32(3);
+    }) == "1\n" + longest_buffered + "\n" + direct + "\n2\n" + huge + "\n3\n" );
+}